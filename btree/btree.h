@@ -15,14 +15,31 @@
 #ifndef PYBTREE_BTREE_H_
 #define PYBTREE_BTREE_H_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cmath>
 #include <concepts>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <iterator>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 // It is recommended to always define `PY_SSIZE_T_CLEAN` before including
 // Python.h. See also: https://docs.python.org/3/c-api/intro.html#include-files
@@ -30,6 +47,8 @@
 #include "Python.h"
 #include "third_party/absl/container/btree_map.h"
 #include "third_party/absl/container/btree_set.h"
+#include "third_party/absl/synchronization/mutex.h"
+#include "btree_allocator.h"
 #include "btree_utils.h"
 
 // TODO: Alert! It will export `string` to the global namespace, i.e.
@@ -51,10 +70,51 @@ using tuple = std::tuple<Args...>;
 template <typename... Args>
 using less = std::less<Args...>;
 
+template <typename... Args>
+using vector = std::vector<Args...>;
+
 namespace djc::btree {
 
 namespace btree_internal {
 
+// All wrapped trees default to `pool_allocator`, which serves nodes from a
+// per-tree arena pool, makes the numbers behind
+// `btree_container::memory_stats` available, and lets
+// `btree_container::release_memory` return the arena to the OS after bulk
+// erases. The CLIF surface is unaffected: the generated class names only
+// mention the wrapper types.
+template <typename Key, typename Compare>
+using absl_btree_set =
+    absl::btree_set<Key, Compare, pool_allocator<Key>>;
+
+template <typename Key, typename Compare>
+using absl_btree_multiset =
+    absl::btree_multiset<Key, Compare, pool_allocator<Key>>;
+
+template <typename Key, typename Data, typename Compare>
+using absl_btree_map =
+    absl::btree_map<Key, Data, Compare,
+                    pool_allocator<std::pair<const Key, Data>>>;
+
+template <typename Key, typename Data, typename Compare>
+using absl_btree_multimap =
+    absl::btree_multimap<Key, Data, Compare,
+                         pool_allocator<std::pair<const Key, Data>>>;
+
+template <typename key_type, typename mapped_type, typename Iterator>
+void inc_ref_for_iterator(Iterator it) {
+  if constexpr (std::is_same_v<key_type, PyObject*>) {
+    if constexpr (std::is_void_v<mapped_type>) {
+      Py_INCREF(*it);
+    } else {
+      Py_INCREF(it->first);
+    }
+  }
+  if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+    Py_INCREF(it->second);
+  }
+}
+
 template <typename key_type, typename mapped_type, typename Iterator>
 void dec_ref_for_iterator(Iterator it) {
   if constexpr (std::is_same_v<key_type, PyObject*>) {
@@ -69,6 +129,23 @@ void dec_ref_for_iterator(Iterator it) {
   }
 }
 
+// The deferred counterpart of `dec_ref_for_iterator`: parks the element's
+// Python references on the process-wide pending-decref buffer (see
+// `defer_decref` in `btree_utils.h`) instead of releasing them inline.
+template <typename key_type, typename mapped_type, typename Iterator>
+void defer_decref_for_iterator(Iterator it) {
+  if constexpr (std::is_same_v<key_type, PyObject*>) {
+    if constexpr (std::is_void_v<mapped_type>) {
+      defer_decref(*it);
+    } else {
+      defer_decref(it->first);
+    }
+  }
+  if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+    defer_decref(it->second);
+  }
+}
+
 template <typename Derived, typename Iterator, typename Key,
           typename Data = void>
 class btree_container_iterator {
@@ -143,17 +220,17 @@ class btree_container_iterator {
 
 template <typename Key, typename Compare>
 class btree_set_iterator
-    : public absl::btree_set<Key, Compare>::iterator,
+    : public btree_internal::absl_btree_set<Key, Compare>::iterator,
       public btree_internal::btree_container_iterator<
           btree_set_iterator<Key, Compare>,
-          typename absl::btree_set<Key, Compare>::iterator, Key> {
+          typename btree_internal::absl_btree_set<Key, Compare>::iterator, Key> {
  private:
   using base_type = btree_internal::btree_container_iterator<
       btree_set_iterator<Key, Compare>,
-      typename absl::btree_set<Key, Compare>::iterator, Key>;
+      typename btree_internal::absl_btree_set<Key, Compare>::iterator, Key>;
 
  public:
-  using btree_type = absl::btree_set<Key, Compare>;
+  using btree_type = btree_internal::absl_btree_set<Key, Compare>;
   using iterator = btree_type::iterator;
 
   explicit btree_set_iterator(iterator it) : iterator(it) {}
@@ -169,17 +246,17 @@ class btree_set_iterator
 
 template <typename Key, typename Compare>
 class btree_multiset_iterator
-    : public absl::btree_multiset<Key, Compare>::iterator,
+    : public btree_internal::absl_btree_multiset<Key, Compare>::iterator,
       public btree_internal::btree_container_iterator<
           btree_multiset_iterator<Key, Compare>,
-          typename absl::btree_multiset<Key, Compare>::iterator, Key> {
+          typename btree_internal::absl_btree_multiset<Key, Compare>::iterator, Key> {
  private:
   using base_type = btree_internal::btree_container_iterator<
       btree_multiset_iterator<Key, Compare>,
-      typename absl::btree_multiset<Key, Compare>::iterator, Key>;
+      typename btree_internal::absl_btree_multiset<Key, Compare>::iterator, Key>;
 
  public:
-  using btree_type = absl::btree_multiset<Key, Compare>;
+  using btree_type = btree_internal::absl_btree_multiset<Key, Compare>;
   using iterator = btree_type::iterator;
 
   explicit btree_multiset_iterator(iterator it) : iterator(it) {}
@@ -195,17 +272,17 @@ class btree_multiset_iterator
 
 template <typename Key, typename Data, typename Compare>
 class btree_map_iterator
-    : public absl::btree_map<Key, Data, Compare>::iterator,
+    : public btree_internal::absl_btree_map<Key, Data, Compare>::iterator,
       public btree_internal::btree_container_iterator<
           btree_map_iterator<Key, Data, Compare>,
-          typename absl::btree_map<Key, Data, Compare>::iterator, Key, Data> {
+          typename btree_internal::absl_btree_map<Key, Data, Compare>::iterator, Key, Data> {
  private:
   using base_type = btree_internal::btree_container_iterator<
       btree_map_iterator<Key, Data, Compare>,
-      typename absl::btree_map<Key, Data, Compare>::iterator, Key, Data>;
+      typename btree_internal::absl_btree_map<Key, Data, Compare>::iterator, Key, Data>;
 
  public:
-  using btree_type = absl::btree_map<Key, Data, Compare>;
+  using btree_type = btree_internal::absl_btree_map<Key, Data, Compare>;
   using iterator = btree_type::iterator;
 
   explicit btree_map_iterator(iterator it) : iterator(it) {}
@@ -221,18 +298,18 @@ class btree_map_iterator
 
 template <typename Key, typename Data, typename Compare>
 class btree_multimap_iterator
-    : public absl::btree_multimap<Key, Data, Compare>::iterator,
+    : public btree_internal::absl_btree_multimap<Key, Data, Compare>::iterator,
       public btree_internal::btree_container_iterator<
           btree_multimap_iterator<Key, Data, Compare>,
-          typename absl::btree_multimap<Key, Data, Compare>::iterator, Key,
+          typename btree_internal::absl_btree_multimap<Key, Data, Compare>::iterator, Key,
           Data> {
  private:
   using base_type = btree_internal::btree_container_iterator<
       btree_multimap_iterator<Key, Data, Compare>,
-      typename absl::btree_multimap<Key, Data, Compare>::iterator, Key, Data>;
+      typename btree_internal::absl_btree_multimap<Key, Data, Compare>::iterator, Key, Data>;
 
  public:
-  using btree_type = absl::btree_multimap<Key, Data, Compare>;
+  using btree_type = btree_internal::absl_btree_multimap<Key, Data, Compare>;
   using iterator = btree_type::iterator;
 
   explicit btree_multimap_iterator(iterator it) : iterator(it) {}
@@ -345,6 +422,67 @@ class btree_view {
   iterator it_;
 };
 
+// The map `value_type` of an items view is `std::pair<const Key, Data>`,
+// which cannot be stored in a `std::vector`. Batched APIs use the
+// non-const-key counterpart instead.
+template <typename T>
+struct chunk_value {
+  using type = T;
+};
+
+template <typename Key, typename Data>
+struct chunk_value<std::pair<const Key, Data>> {
+  using type = std::pair<Key, Data>;
+};
+
+template <typename T>
+using chunk_value_t = chunk_value<T>::type;
+
+// Reverse-walking adapter over any `btree_view`. Following the
+// `std::reverse_iterator` convention, it stores the forward view one past the
+// element it yields, so the reversed range is `[_end(), _begin())` and a tail
+// scan of k elements costs O(k) instead of materializing and reversing the
+// whole view in Python.
+template <typename View>
+class btree_reverse_view {
+ public:
+  using value_type = View::value_type;
+  using difference_type = ptrdiff_t;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using iterator_category = std::forward_iterator_tag;
+
+  explicit btree_reverse_view(View view) : view_(view) {}
+
+  btree_reverse_view& operator++() {
+    --view_;
+    return *this;
+  }
+
+  btree_reverse_view operator++(int) {
+    btree_reverse_view self = *this;
+    --view_;
+    return self;
+  }
+
+  auto operator*() {
+    View prev = view_;
+    --prev;
+    return *prev;
+  }
+
+  bool operator==(const btree_reverse_view& rhs) const {
+    return view_ == rhs.view_;
+  }
+
+  bool operator!=(const btree_reverse_view& rhs) const {
+    return view_ != rhs.view_;
+  }
+
+ private:
+  View view_;
+};
+
 template <template <typename...> typename Btree,
           template <typename...> typename View, typename... Args>
 class btree_view_generator {
@@ -352,17 +490,312 @@ class btree_view_generator {
   using btree_type = Btree<Args...>;
   using btree_view = View<Args...>;
   using iterator = btree_type::iterator;
+  using chunk_value_type = chunk_value_t<typename btree_view::value_type>;
 
   explicit btree_view_generator(btree_type& btree)
-      : begin_(btree._begin()), end_(btree._end()) {}
+      : begin_(btree._begin()), cursor_(btree._begin()), end_(btree._end()) {}
+
+  btree_view begin() { return begin_; }
+
+  btree_view end() { return end_; }
+
+  // Advances the view by up to `n` elements entirely in C++ and returns them
+  // as one pre-built batch, instead of one Python call pair per element. An
+  // empty batch signals that the view is exhausted. Mixing `next_chunk` with
+  // `__iter__` is fine: the chunk cursor is independent of iterators handed
+  // out by `begin`.
+  std::vector<chunk_value_type> next_chunk(size_t n) {
+    std::vector<chunk_value_type> chunk;
+    chunk.reserve(n);
+    while (n-- > 0 && cursor_ != end_) {
+      chunk.push_back(*cursor_);
+      ++cursor_;
+    }
+    return chunk;
+  }
+
+  // Like `next_chunk`, but overlaps materialization with consumption: each
+  // call returns the chunk built by the previous call's worker thread and
+  // kicks off materialization of the next one in the background, so Python
+  // processes chunk N while C++ walks chunk N+1. The worker only copies out
+  // of the tree (no Python calls), so it runs without the GIL; the GIL is
+  // released here too while waiting for it. After the first call, stick to
+  // `prefetch_next_chunk` — `next_chunk` and `__iter__` would race with the
+  // in-flight worker.
+  std::vector<chunk_value_type> prefetch_next_chunk(size_t n) {
+    // A non-empty `prefetched_` without a worker holds the chunk carried
+    // over by a move; hand it out before prefetching any further.
+    if (worker_.joinable() || prefetched_.empty()) {
+      gil_release<true> allow_threads;
+      if (!worker_.joinable()) {
+        // First call: nothing is in flight yet, materialize synchronously.
+        start_prefetch(n);
+      }
+      worker_.join();
+    }
+    std::vector<chunk_value_type> chunk = std::move(prefetched_);
+    prefetched_.clear();
+    if (!chunk.empty()) {
+      start_prefetch(n);
+    }
+    return chunk;
+  }
+
+  ~btree_view_generator() { settle(); }
+
+  // The worker lambda captures `this`, so a move with a prefetch in flight
+  // would leave it writing into the moved-from object — and move-assigning
+  // over a joinable `std::thread` calls `std::terminate`. Both move
+  // operations therefore settle the in-flight prefetch first; the built
+  // chunk is carried along in `prefetched_` and handed out as usual by the
+  // next `prefetch_next_chunk` call on the destination.
+  btree_view_generator(btree_view_generator&& rhs)
+      : begin_(std::move(rhs.settle().begin_)),
+        cursor_(std::move(rhs.cursor_)),
+        end_(std::move(rhs.end_)),
+        prefetched_(std::move(rhs.prefetched_)) {}
+
+  btree_view_generator& operator=(btree_view_generator&& rhs) {
+    if (this != &rhs) {
+      settle();
+      rhs.settle();
+      begin_ = std::move(rhs.begin_);
+      cursor_ = std::move(rhs.cursor_);
+      end_ = std::move(rhs.end_);
+      prefetched_ = std::move(rhs.prefetched_);
+    }
+    return *this;
+  }
+
+ private:
+  // Joins the prefetch worker, if any, so no thread still refers to `this`.
+  btree_view_generator& settle() {
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    return *this;
+  }
+
+  void start_prefetch(size_t n) {
+    worker_ = std::thread([this, n] { prefetched_ = next_chunk(n); });
+  }
+
+  btree_view begin_;
+  btree_view cursor_;
+  btree_view end_;
+  std::thread worker_;
+  std::vector<chunk_value_type> prefetched_;
+};
+
+// The backward counterpart of `btree_view_generator`, backing the
+// `reversed_keys()`/`reversed_values()`/`reversed_items()` methods. The CLIF
+// surface (iteration plus `next_chunk`) is identical; only the walk direction
+// differs.
+template <template <typename...> typename Btree,
+          template <typename...> typename View, typename... Args>
+class btree_reverse_view_generator {
+ public:
+  using btree_type = Btree<Args...>;
+  using forward_view = View<Args...>;
+  using btree_view = btree_reverse_view<forward_view>;
+  using chunk_value_type = chunk_value_t<typename forward_view::value_type>;
+
+  explicit btree_reverse_view_generator(btree_type& btree)
+      : begin_(btree_view(forward_view(btree._end()))),
+        cursor_(begin_),
+        end_(btree_view(forward_view(btree._begin()))) {}
 
   btree_view begin() { return begin_; }
 
   btree_view end() { return end_; }
 
+  // See `btree_view_generator::next_chunk`; the chunk is in descending key
+  // order.
+  std::vector<chunk_value_type> next_chunk(size_t n) {
+    std::vector<chunk_value_type> chunk;
+    chunk.reserve(n);
+    while (n-- > 0 && cursor_ != end_) {
+      chunk.push_back(*cursor_);
+      ++cursor_;
+    }
+    return chunk;
+  }
+
+  // See `btree_view_generator::prefetch_next_chunk`; chunks arrive in
+  // descending key order.
+  std::vector<chunk_value_type> prefetch_next_chunk(size_t n) {
+    // A non-empty `prefetched_` without a worker holds the chunk carried
+    // over by a move; hand it out before prefetching any further.
+    if (worker_.joinable() || prefetched_.empty()) {
+      gil_release<true> allow_threads;
+      if (!worker_.joinable()) {
+        start_prefetch(n);
+      }
+      worker_.join();
+    }
+    std::vector<chunk_value_type> chunk = std::move(prefetched_);
+    prefetched_.clear();
+    if (!chunk.empty()) {
+      start_prefetch(n);
+    }
+    return chunk;
+  }
+
+  ~btree_reverse_view_generator() { settle(); }
+
+  // See `btree_view_generator`: both move operations must join the prefetch
+  // worker first, since its lambda captures `this`.
+  btree_reverse_view_generator(btree_reverse_view_generator&& rhs)
+      : begin_(std::move(rhs.settle().begin_)),
+        cursor_(std::move(rhs.cursor_)),
+        end_(std::move(rhs.end_)),
+        prefetched_(std::move(rhs.prefetched_)) {}
+
+  btree_reverse_view_generator& operator=(btree_reverse_view_generator&& rhs) {
+    if (this != &rhs) {
+      settle();
+      rhs.settle();
+      begin_ = std::move(rhs.begin_);
+      cursor_ = std::move(rhs.cursor_);
+      end_ = std::move(rhs.end_);
+      prefetched_ = std::move(rhs.prefetched_);
+    }
+    return *this;
+  }
+
  private:
+  // Joins the prefetch worker, if any, so no thread still refers to `this`.
+  btree_reverse_view_generator& settle() {
+    if (worker_.joinable()) {
+      worker_.join();
+    }
+    return *this;
+  }
+
+  void start_prefetch(size_t n) {
+    worker_ = std::thread([this, n] { prefetched_ = next_chunk(n); });
+  }
+
   btree_view begin_;
+  btree_view cursor_;
   btree_view end_;
+  std::thread worker_;
+  std::vector<chunk_value_type> prefetched_;
+};
+
+// Stateful lookup handle that exploits key locality: consecutive probes in a
+// sorted-ish workload (e.g. time-ordered keys) usually land on the same or a
+// neighboring element, so the cursor remembers where the previous probe ended
+// and first checks that position and its immediate neighbors — a handful of
+// comparisons, no node visits — before falling back to a full root-to-leaf
+// search. Obtained from `btree_container::cursor`. The cached position obeys
+// the same invalidation contract as raw iterators: any mutation of the tree
+// invalidates it. A size change drops the cache automatically; after a
+// size-preserving sequence of mutations, take a fresh cursor.
+template <typename Btree, typename Iterator>
+class btree_cursor {
+ public:
+  using btree_type = Btree;
+  using key_type = btree_type::key_type;
+
+ private:
+  using key_arg_type = std::conditional_t<std::is_pointer_v<key_type>,
+                                          key_type, const key_type&>;
+  using tree_iterator = btree_type::iterator;
+
+ public:
+  explicit btree_cursor(btree_type& tree) : tree_(&tree) {}
+
+  bool _contains(key_arg_type key) {
+    tree_iterator it = seek(key);
+    return it != tree_->end() && !tree_->key_comp()(key, key_of(*it));
+  }
+
+  Iterator _find(key_arg_type key) {
+    tree_iterator it = seek(key);
+    if (it != tree_->end() && tree_->key_comp()(key, key_of(*it))) {
+      it = tree_->end();
+    }
+    return Iterator(it);
+  }
+
+  Iterator _lower_bound(key_arg_type key) { return Iterator(seek(key)); }
+
+  // Heterogeneous twins for string-keyed trees; see
+  // `btree_container::_contains_view`.
+  bool _contains_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    tree_iterator it = seek(key);
+    return it != tree_->end() && !tree_->key_comp()(key, key_of(*it));
+  }
+
+  Iterator _find_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    tree_iterator it = seek(key);
+    if (it != tree_->end() && tree_->key_comp()(key, key_of(*it))) {
+      it = tree_->end();
+    }
+    return Iterator(it);
+  }
+
+  Iterator _lower_bound_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    return Iterator(seek(key));
+  }
+
+ private:
+  static const key_type& key_of(const btree_type::value_type& value) {
+    if constexpr (std::is_same_v<typename btree_type::value_type, key_type>) {
+      return value;
+    } else {
+      return value.first;
+    }
+  }
+
+  // A cached `lower_bound`: resolves probes adjacent to the previous one in
+  // O(1) comparisons and descends from the root only on a cache miss.
+  template <typename K>
+  tree_iterator seek(const K& key) {
+    const auto& comp = tree_->key_comp();
+    if (valid_ && cached_size_ != tree_->size()) {
+      valid_ = false;
+    }
+    if (valid_ && cached_ != tree_->end() && !comp(key_of(*cached_), key)) {
+      // `key <= *cached_`: the answer is `cached_` or just before it.
+      if (cached_ == tree_->begin()) {
+        return remember(cached_);
+      }
+      tree_iterator prev = std::prev(cached_);
+      if (comp(key_of(*prev), key)) {
+        return remember(cached_);
+      }
+      if (prev == tree_->begin() || comp(key_of(*std::prev(prev)), key)) {
+        return remember(prev);
+      }
+    } else if (valid_ && cached_ != tree_->end()) {
+      // `*cached_ < key`: the answer may be the immediate successor.
+      tree_iterator next = std::next(cached_);
+      if (next == tree_->end() || !comp(key_of(*next), key)) {
+        return remember(next);
+      }
+    }
+    return remember(tree_->lower_bound(key));
+  }
+
+  tree_iterator remember(tree_iterator it) {
+    cached_ = it;
+    cached_size_ = tree_->size();
+    valid_ = true;
+    return it;
+  }
+
+  btree_type* tree_;
+  tree_iterator cached_;
+  size_t cached_size_ = 0;
+  bool valid_ = false;
 };
 
 }  // namespace btree_internal
@@ -409,6 +842,153 @@ using btree_multimap_items_view =
 
 namespace btree_internal {
 
+// Identifies snapshot files written by `btree_container::save`. Bump the
+// trailing digit whenever the record format changes.
+inline constexpr char kSnapshotMagic[] = "PYBTREE1";
+inline constexpr size_t kSnapshotMagicSize = sizeof(kSnapshotMagic) - 1;
+
+// Identifies frozen index files written by `btree_map::freeze`. The layout is
+// the magic, a `uint64_t` element count, the dense sorted key array, zero
+// padding up to 8-byte alignment, then the dense value array.
+inline constexpr char kFrozenMagic[] = "PYBFROZ1";
+inline constexpr size_t kFrozenMagicSize = sizeof(kFrozenMagic) - 1;
+inline constexpr size_t kFrozenHeaderSize =
+    kFrozenMagicSize + sizeof(uint64_t);
+
+inline constexpr size_t align_to_8(size_t offset) {
+  return (offset + 7) & ~size_t{7};
+}
+
+// Writes one field to the snapshot stream: raw fixed-width bytes for
+// arithmetic types, length-prefixed bytes for `std::string`, field-by-field
+// recursion for `std::pair`/`std::tuple` composite keys, and length-prefixed
+// pickle for `PyObject*`.
+template <typename T>
+void write_snapshot_field(std::ostream& out, const T& value) {
+  if constexpr (std::is_arithmetic_v<T>) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    const uint64_t length = value.size();
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(value.data(), length);
+  } else if constexpr (std::is_same_v<T, PyObject*>) {
+    gil_guard<> _;
+    PyObject* pickle = PyImport_ImportModule("pickle");
+    PyObject* bytes =
+        pickle == nullptr
+            ? nullptr
+            : PyObject_CallMethod(pickle, "dumps", "O", value);
+    Py_XDECREF(pickle);
+    if (bytes == nullptr) {
+      PyErr_Clear();
+      throw std::runtime_error("failed to pickle an element for the snapshot");
+    }
+    const uint64_t length = PyBytes_GET_SIZE(bytes);
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(PyBytes_AS_STRING(bytes), length);
+    Py_DECREF(bytes);
+  } else {
+    std::apply(
+        [&out](const auto&... fields) {
+          (write_snapshot_field(out, fields), ...);
+        },
+        value);
+  }
+}
+
+// Reads back one field written by `write_snapshot_field`. For `PyObject*`
+// the returned reference is new and owned by the caller.
+template <typename T>
+T read_snapshot_field(std::istream& in) {
+  if constexpr (std::is_arithmetic_v<T>) {
+    T value;
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    uint64_t length;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    std::string value(length, '\0');
+    in.read(value.data(), length);
+    return value;
+  } else if constexpr (std::is_same_v<T, PyObject*>) {
+    uint64_t length;
+    in.read(reinterpret_cast<char*>(&length), sizeof(length));
+    gil_guard<> _;
+    PyObject* bytes = PyBytes_FromStringAndSize(nullptr, length);
+    if (bytes == nullptr) {
+      PyErr_Clear();
+      throw std::runtime_error("failed to allocate a snapshot record buffer");
+    }
+    in.read(PyBytes_AS_STRING(bytes), length);
+    PyObject* pickle = PyImport_ImportModule("pickle");
+    PyObject* value =
+        pickle == nullptr
+            ? nullptr
+            : PyObject_CallMethod(pickle, "loads", "O", bytes);
+    Py_XDECREF(pickle);
+    Py_DECREF(bytes);
+    if (value == nullptr) {
+      PyErr_Clear();
+      throw std::runtime_error("failed to unpickle a snapshot element");
+    }
+    return value;
+  } else {
+    T value;
+    std::apply(
+        [&in](auto&... fields) {
+          ((fields =
+                read_snapshot_field<std::remove_reference_t<decltype(fields)>>(
+                    in)),
+           ...);
+        },
+        value);
+    return value;
+  }
+}
+
+// TSV helpers for `btree_container::build_from_file`. A scalar or string
+// element occupies one tab-separated column; a pair/tuple key occupies one
+// column per component.
+template <typename T>
+struct tsv_arity : std::integral_constant<size_t, 1> {};
+
+template <typename... Ts>
+struct tsv_arity<std::tuple<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {};
+
+template <typename A, typename B>
+struct tsv_arity<std::pair<A, B>> : std::integral_constant<size_t, 2> {};
+
+// Parses one column into a native scalar or string; returns whether the
+// whole column was consumed.
+template <typename T>
+bool parse_tsv_field(std::string_view field, T& out) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    out.assign(field);
+    return true;
+  } else {
+    auto [end, ec] =
+        std::from_chars(field.data(), field.data() + field.size(), out);
+    return ec == std::errc() && end == field.data() + field.size();
+  }
+}
+
+// Parses a record element out of `fields` starting at column `offset`,
+// expanding pair/tuple keys over consecutive columns.
+template <typename T>
+bool parse_tsv_element(const std::vector<std::string_view>& fields,
+                       size_t offset, T& out) {
+  if constexpr (tsv_arity<T>::value == 1) {
+    return parse_tsv_field(fields[offset], out);
+  } else {
+    return std::apply(
+        [&fields, &offset](auto&... components) {
+          return (parse_tsv_field(fields[offset++], components) && ...);
+        },
+        out);
+  }
+}
+
 template <typename, class = void>
 struct get_mapped_type_or_void {
   using type = void;
@@ -432,6 +1012,12 @@ class btree_container {
   using key_type = btree_type::key_type;
   using mapped_type = get_mapped_type_or_void_t<btree_type>;
   using value_type = btree_type::value_type;
+  // The map `value_type` is `std::pair<const key_type, mapped_type>`, which
+  // cannot be stored in a `std::vector`. Bulk APIs use the non-const-key
+  // counterpart instead, which converts to `value_type` implicitly.
+  using bulk_value_type = DJC_BTREE_LAZY_CONDITIONAL_T(
+      std::is_void_v<mapped_type>, key_type,
+      DJC_BTREE_SINGLE_ARG(std::pair<key_type, mapped_type>));
 
  private:
   using key_arg_type = std::conditional_t<std::is_pointer_v<key_type>, key_type,
@@ -448,6 +1034,19 @@ class btree_container {
     return reinterpret_cast<btree_type*>(this);
   }
 
+  // Iterator pair delimiting the keys in `[lo, hi)`. An inverted range
+  // (`lo >= hi`) yields an empty pair; computing both bounds independently
+  // would put `first` after `last`, and walking or erasing such a pair is
+  // undefined behavior. Every ranged method must go through this helper.
+  std::pair<typename btree_type::iterator, typename btree_type::iterator>
+  range_bounds(key_arg_type lo, key_arg_type hi) {
+    auto first = btree()->lower_bound(lo);
+    if (!btree()->key_comp()(lo, hi)) {
+      return {first, first};
+    }
+    return {first, btree()->lower_bound(hi)};
+  }
+
  public:
   bool not_empty() { return !btree()->empty(); }
 
@@ -472,6 +1071,74 @@ class btree_container {
     return iterator(btree()->upper_bound(key));
   }
 
+  // Heterogeneous twins of the point lookups above for string-keyed trees.
+  // CLIF fills the `string_view` straight from the UTF-8 buffer of the Python
+  // str, so a probe no longer heap-allocates a `std::string`; the generator
+  // routes the Python-visible lookups of string-keyed classes through these.
+  bool _contains_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    return btree()->contains(key);
+  }
+
+  iterator _find_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    return iterator(btree()->find(key));
+  }
+
+  iterator _lower_bound_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    return iterator(btree()->lower_bound(key));
+  }
+
+  iterator _upper_bound_view(std::string_view key)
+    requires(std::is_same_v<key_type, std::string>)
+  {
+    return iterator(btree()->upper_bound(key));
+  }
+
+  using cursor_type = btree_internal::btree_cursor<btree_type, iterator>;
+
+  // Returns a stateful lookup handle that caches the position of the last
+  // probe, turning adjacent-key lookup sequences into O(1) neighbor checks
+  // instead of full descents; see `btree_internal::btree_cursor`.
+  cursor_type cursor() { return cursor_type(*btree()); }
+
+  // Returns an iterator to the i-th smallest key. The `absl` b-tree does not
+  // keep subtree counts and cannot be augmented without forking it, so this
+  // walks from the nearer end of the tree; the walk stays in C++, which makes
+  // percentile queries a single binding crossing instead of one Python call
+  // per step.
+  iterator nth(size_type i) {
+    const size_type count = btree()->size();
+    if (i >= count) {
+      throw std::out_of_range("index is out of range");
+    }
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    if (i <= count / 2) {
+      auto it = btree()->begin();
+      std::advance(it, static_cast<std::ptrdiff_t>(i));
+      return iterator(it);
+    }
+    auto it = btree()->end();
+    std::advance(it, -static_cast<std::ptrdiff_t>(count - i));
+    return iterator(it);
+  }
+
+  // Returns the number of keys strictly less than `key`, i.e. the index `key`
+  // would have in sorted order. Same caveat as `nth`: linear in the rank, but
+  // entirely native.
+  size_type rank(key_arg_type key) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    return std::distance(btree()->begin(), btree()->lower_bound(key));
+  }
+
   std::pair<iterator, bool> _insert(value_arg_type value) {
     auto [it, inserted] = btree()->insert(value);
     if (inserted) {
@@ -489,71 +1156,527 @@ class btree_container {
     return std::make_pair(iterator(it), inserted);
   }
 
-  size_type _erase(key_arg_type key) {
-    if constexpr (!std::is_same_v<key_type, PyObject*> &&
-                  !std::is_same_v<mapped_type, PyObject*>) {
-      return btree()->erase(key);
-    } else if (auto it = btree()->find(key); it == btree()->end()) {
-      return 0;
-    } else {
-      {
-        gil_guard<> _;
-        btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+  // Inserts all elements of `values` in a single call, so that the whole
+  // sequence is converted once instead of paying one binding crossing per
+  // element. Returns the number of elements actually inserted.
+  size_type _insert_many(const std::vector<bulk_value_type>& values) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    size_type inserted_count = 0;
+    for (const bulk_value_type& value : values) {
+      if (_insert(value).second) {
+        ++inserted_count;
       }
-      btree()->erase(it);
-      return 1;
     }
+    return inserted_count;
   }
 
-  iterator remove(iterator it) {
-    if constexpr (std::is_same_v<key_type, PyObject*> ||
-                  std::is_same_v<mapped_type, PyObject*>) {
-      gil_guard<> _;
-      btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+  // Bulk-loads `values`, which must already be sorted by key, replacing the
+  // current content. Every element is inserted with an end hint, so the
+  // sorted sequence is loaded in amortized O(1) per element instead of a full
+  // root-to-leaf descent plus split churn per key. The `absl` b-tree keeps
+  // hint-inserted runs densely packed, which also gives near-full leaves.
+  void _from_sorted(const std::vector<bulk_value_type>& values) {
+    _clear();
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    for (const bulk_value_type& value : values) {
+      if constexpr (std::is_same_v<key_type, PyObject*> ||
+                    std::is_same_v<mapped_type, PyObject*>) {
+        const size_type old_size = btree()->size();
+        auto it = btree()->insert(btree()->end(), value);
+        // Hinted insertion on a unique container skips duplicated keys.
+        if (btree()->size() != old_size) {
+          btree_internal::inc_ref_for_iterator<key_type, mapped_type>(it);
+        }
+      } else {
+        btree()->insert(btree()->end(), value);
+      }
     }
-    return iterator(btree()->erase(static_cast<btree_type::iterator>(it)));
   }
 
-  void _clear() {
-    release();
-    btree()->clear();
+  // Bulk-loads keys straight out of an object exporting the Python buffer
+  // protocol (e.g. a NumPy array), never materializing a Python object per
+  // element. The buffer must be C-contiguous and its item size and format
+  // code must match `key_type` (e.g. `numpy.int32` for `int`-keyed trees).
+  // Returns the number of elements inserted.
+  size_type insert_array(PyObject* keys_buf)
+    requires(std::is_arithmetic_v<key_type> && std::is_void_v<mapped_type>)
+  {
+    buffer_guard keys(keys_buf, sizeof(key_type), buffer_formats<key_type>());
+    // Elements are arithmetic, so nothing below touches Python objects.
+    gil_release<> _;
+    const size_type old_size = btree()->size();
+    const key_type* keys_data = keys.template data<key_type>();
+    for (Py_ssize_t i = 0; i < keys.size(); ++i) {
+      btree()->insert(keys_data[i]);
+    }
+    return btree()->size() - old_size;
   }
 
-  ~btree_container() { release(); }
+  // Same as above but for maps: keys and values come from two parallel
+  // buffers, which must have the same length.
+  size_type insert_array(PyObject* keys_buf, PyObject* values_buf)
+    requires(std::is_arithmetic_v<key_type> && std::is_arithmetic_v<mapped_type>)
+  {
+    buffer_guard keys(keys_buf, sizeof(key_type), buffer_formats<key_type>());
+    buffer_guard values(values_buf, sizeof(mapped_type),
+                        buffer_formats<mapped_type>());
+    if (keys.size() != values.size()) {
+      throw std::invalid_argument(
+          "key and value buffers must have the same length");
+    }
+    // Elements are arithmetic, so nothing below touches Python objects.
+    gil_release<> _;
+    const size_type old_size = btree()->size();
+    const key_type* keys_data = keys.template data<key_type>();
+    const mapped_type* values_data = values.template data<mapped_type>();
+    for (Py_ssize_t i = 0; i < keys.size(); ++i) {
+      btree()->insert(value_type(keys_data[i], values_data[i]));
+    }
+    return btree()->size() - old_size;
+  }
 
- private:
-  void release() {
-    if constexpr (std::is_same_v<key_type, PyObject*> ||
-                  std::is_same_v<mapped_type, PyObject*>) {
-      gil_guard<> _;
-      if constexpr (std::is_void_v<mapped_type>) {
-        for (auto&& key : *btree()) {
-          Py_DECREF(key);
-        }
-      } else {
-        for (auto&& [key, value] : *btree()) {
-          if constexpr (std::is_same_v<key_type, PyObject*>) {
-            Py_DECREF(key);
-          }
-          if constexpr (std::is_same_v<mapped_type, PyObject*>) {
-            Py_DECREF(value);
-          }
-        }
+  // Exports the tree content as raw native-endian `bytes` suitable for
+  // `numpy.frombuffer`. Sets return one bytes object of keys; maps return a
+  // `(keys, values)` tuple. One copy out of the tree nodes is unavoidable
+  // since they are not contiguous, but no per-element Python object is built.
+  PyObject* extract_arrays()
+    requires(std::is_arithmetic_v<key_type> &&
+             (std::is_void_v<mapped_type> || std::is_arithmetic_v<mapped_type>))
+  {
+    const Py_ssize_t count = btree()->size();
+    PyObject* keys_bytes =
+        PyBytes_FromStringAndSize(nullptr, count * sizeof(key_type));
+    if (keys_bytes == nullptr) {
+      return nullptr;
+    }
+    key_type* keys_data =
+        reinterpret_cast<key_type*>(PyBytes_AS_STRING(keys_bytes));
+    if constexpr (std::is_void_v<mapped_type>) {
+      for (const key_type& key : *btree()) {
+        *keys_data++ = key;
+      }
+      return keys_bytes;
+    } else {
+      PyObject* values_bytes =
+          PyBytes_FromStringAndSize(nullptr, count * sizeof(mapped_type));
+      if (values_bytes == nullptr) {
+        Py_DECREF(keys_bytes);
+        return nullptr;
+      }
+      mapped_type* values_data =
+          reinterpret_cast<mapped_type*>(PyBytes_AS_STRING(values_bytes));
+      for (const auto& [key, value] : *btree()) {
+        *keys_data++ = key;
+        *values_data++ = value;
       }
+      PyObject* result = PyTuple_Pack(2, keys_bytes, values_bytes);
+      Py_DECREF(keys_bytes);
+      Py_DECREF(values_bytes);
+      return result;
     }
   }
-};
 
-template <typename Btree, typename KeyView>
-class btree_multi_container : public btree_container<Btree, KeyView> {
- public:
-  using btree_type = Btree;
-  using keys_view = KeyView;
-  using iterator = keys_view::iterator;
-  using size_type = btree_type::size_type;
+  // Materializes all elements with key in `[lo, hi)` as one batch. The range
+  // is walked entirely in C++ and handed to Python as a single list, instead
+  // of one iterator object plus three binding crossings per element. A
+  // non-zero `limit` caps the number of returned elements.
+  std::vector<bulk_value_type> _range(key_arg_type lo, key_arg_type hi,
+                                      size_type limit = 0) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    std::vector<bulk_value_type> result;
+    auto [it, last] = range_bounds(lo, hi);
+    for (; it != last; ++it) {
+      if (limit != 0 && result.size() == limit) {
+        break;
+      }
+      btree_internal::inc_ref_for_iterator<key_type, mapped_type>(it);
+      result.push_back(*it);
+    }
+    return result;
+  }
+
+  // Streams the tree to `path` in a compact binary snapshot: a magic header,
+  // the element count, then the records in key order (raw fixed-width bytes
+  // for arithmetic fields, length-prefixed bytes for strings, pickle for
+  // `PyObject*`). The records being sorted, `load` can take the end-hinted
+  // bulk-load path and stay I/O-bound instead of tree-insertion-bound.
+  void save(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("cannot open snapshot file for writing: " +
+                               path);
+    }
+    out.write(btree_internal::kSnapshotMagic,
+              btree_internal::kSnapshotMagicSize);
+    const uint64_t count = btree()->size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (auto it = btree()->begin(); it != btree()->end(); ++it) {
+      if constexpr (std::is_void_v<mapped_type>) {
+        btree_internal::write_snapshot_field(out, *it);
+      } else {
+        btree_internal::write_snapshot_field(out, it->first);
+        btree_internal::write_snapshot_field(out, it->second);
+      }
+    }
+    if (!out) {
+      throw std::runtime_error("failed to write snapshot file: " + path);
+    }
+  }
+
+  // Replaces the tree content with the snapshot at `path` written by `save`.
+  void load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+      throw std::runtime_error("cannot open snapshot file for reading: " +
+                               path);
+    }
+    char magic[btree_internal::kSnapshotMagicSize];
+    in.read(magic, btree_internal::kSnapshotMagicSize);
+    if (!in || std::memcmp(magic, btree_internal::kSnapshotMagic,
+                           btree_internal::kSnapshotMagicSize) != 0) {
+      throw std::runtime_error("not a pybtree snapshot file: " + path);
+    }
+    uint64_t count;
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    _clear();
+    for (uint64_t i = 0; i < count && in; ++i) {
+      bulk_value_type value = read_snapshot_record(in);
+      const size_type old_size = btree()->size();
+      btree()->insert(btree()->end(), value);
+      // `read_snapshot_field` hands over owned references; a duplicated key
+      // in a unique container drops the record, so give the references back.
+      if constexpr (std::is_same_v<key_type, PyObject*> ||
+                    std::is_same_v<mapped_type, PyObject*>) {
+        if (btree()->size() == old_size) {
+          gil_guard<> _;
+          if constexpr (std::is_void_v<mapped_type>) {
+            Py_DECREF(value);
+          } else {
+            if constexpr (std::is_same_v<key_type, PyObject*>) {
+              Py_DECREF(value.first);
+            }
+            if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+              Py_DECREF(value.second);
+            }
+          }
+        }
+      }
+    }
+    if (!in) {
+      throw std::runtime_error("truncated snapshot file: " + path);
+    }
+  }
+
+  // Replaces the tree content by streaming records straight from a sorted
+  // file, never materializing a Python object per record: peak memory is the
+  // tree plus one line buffer, instead of file-as-list-of-tuples plus tree.
+  // `format` is "tsv" (one record per line, one column per key component,
+  // plus one trailing value column for maps) or "binary" (the `save`
+  // snapshot format). Records being sorted, every insert is end-hinted and
+  // amortized O(1) like `_from_sorted`; out-of-order rows still load
+  // correctly, just slower.
+  void build_from_file(const std::string& path, const std::string& format)
+    requires(!std::is_same_v<key_type, PyObject*> &&
+             !std::is_same_v<mapped_type, PyObject*>)
+  {
+    if (format == "binary") {
+      load(path);
+      return;
+    }
+    if (format != "tsv") {
+      throw std::invalid_argument("unknown build_from_file format: " + format);
+    }
+    std::ifstream in(path);
+    if (!in) {
+      throw std::runtime_error("cannot open file for reading: " + path);
+    }
+    // Elements are native, so nothing below touches Python objects.
+    gil_release<> _;
+    btree()->clear();
+    constexpr size_t column_count = btree_internal::tsv_arity<key_type>::value +
+                                    (std::is_void_v<mapped_type> ? 0 : 1);
+    std::string line;
+    std::vector<std::string_view> fields;
+    size_t line_number = 0;
+    while (std::getline(in, line)) {
+      ++line_number;
+      if (line.empty()) {
+        continue;
+      }
+      fields.clear();
+      std::string_view rest(line);
+      for (size_t tab; (tab = rest.find('\t')) != std::string_view::npos;
+           rest.remove_prefix(tab + 1)) {
+        fields.push_back(rest.substr(0, tab));
+      }
+      fields.push_back(rest);
+      bulk_value_type value{};
+      bool parsed = fields.size() == column_count;
+      if (parsed) {
+        if constexpr (std::is_void_v<mapped_type>) {
+          parsed = btree_internal::parse_tsv_element(fields, 0, value);
+        } else {
+          parsed =
+              btree_internal::parse_tsv_element(fields, 0, value.first) &&
+              btree_internal::parse_tsv_element(
+                  fields, btree_internal::tsv_arity<key_type>::value,
+                  value.second);
+        }
+      }
+      if (!parsed) {
+        throw std::runtime_error("malformed record at " + path + ":" +
+                                 std::to_string(line_number));
+      }
+      btree()->insert(btree()->end(), value);
+    }
+  }
+
+  size_type _erase(key_arg_type key) {
+    if constexpr (!std::is_same_v<key_type, PyObject*> &&
+                  !std::is_same_v<mapped_type, PyObject*>) {
+      return btree()->erase(key);
+    } else if (auto it = btree()->find(key); it == btree()->end()) {
+      return 0;
+    } else {
+      {
+        gil_guard<> _;
+        btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+      }
+      btree()->erase(it);
+      return 1;
+    }
+  }
+
+  // Like `_erase`, but the erased element's Python references are parked on
+  // the process-wide pending-decref buffer instead of being released inline,
+  // keeping cascading deallocations (and `PyGILState_Ensure`) off the erase
+  // path; call `flush_pending_decrefs` at a convenient point to release
+  // them. Identical to `_erase` for trees without object elements.
+  size_type _erase_deferred(key_arg_type key) {
+    if constexpr (!std::is_same_v<key_type, PyObject*> &&
+                  !std::is_same_v<mapped_type, PyObject*>) {
+      return btree()->erase(key);
+    } else if (auto it = btree()->find(key); it == btree()->end()) {
+      return 0;
+    } else {
+      btree_internal::defer_decref_for_iterator<key_type, mapped_type>(it);
+      btree()->erase(it);
+      return 1;
+    }
+  }
+
+  // Counts the elements with a key in `[lo, hi)` without materializing them.
+  size_type _count_range(key_arg_type lo, key_arg_type hi) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    auto [first, last] = range_bounds(lo, hi);
+    return std::distance(first, last);
+  }
+
+  // Erases every element with a key in `[lo, hi)` as one native operation:
+  // both bounds are computed once, the reference-count pass runs under a
+  // single `gil_guard` (the pattern `btree_multi_container::_erase` uses) and
+  // the underlying ranged `erase` rebalances once, instead of one binding
+  // crossing and one rebalance per element when looping `remove` from
+  // Python. Returns the number of elements removed.
+  size_type _erase_range(key_arg_type lo, key_arg_type hi) {
+    auto [first, last] = range_bounds(lo, hi);
+    size_type removed_count = 0;
+    if constexpr (std::is_same_v<key_type, PyObject*> ||
+                  std::is_same_v<mapped_type, PyObject*>) {
+      gil_guard<> _;
+      for (auto it = first; it != last; ++it) {
+        ++removed_count;
+        btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+      }
+    } else {
+      removed_count = std::distance(first, last);
+    }
+    btree()->erase(first, last);
+    return removed_count;
+  }
+
+  iterator remove(iterator it) {
+    if constexpr (std::is_same_v<key_type, PyObject*> ||
+                  std::is_same_v<mapped_type, PyObject*>) {
+      gil_guard<> _;
+      btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+    }
+    return iterator(btree()->erase(static_cast<btree_type::iterator>(it)));
+  }
+
+  // Erases and returns the smallest element in one call, replacing the
+  // `begin` / `deref` / `remove` triple (three binding crossings and two
+  // temporary iterator objects) that a queue drain otherwise pays per
+  // element. The tree's own references travel with the returned element, so
+  // no reference counts are touched.
+  bulk_value_type pop_first() {
+    if (btree()->empty()) {
+      throw std::out_of_range("pop from an empty tree");
+    }
+    auto it = btree()->begin();
+    bulk_value_type value(*it);
+    btree()->erase(it);
+    return value;
+  }
+
+  // Same as `pop_first` but for the largest element.
+  bulk_value_type pop_last() {
+    if (btree()->empty()) {
+      throw std::out_of_range("pop from an empty tree");
+    }
+    auto it = --btree()->end();
+    bulk_value_type value(*it);
+    btree()->erase(it);
+    return value;
+  }
+
+  // Moves the content of `other` into this tree by relinking nodes instead of
+  // copying elements, leaving `other` with whatever could not be moved (for
+  // unique containers, the keys already present here). Python references
+  // travel with the moved elements, so no reference counts change hands.
+  void merge_from(btree_container& other) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    btree()->merge(*other.btree());
+  }
+
+  void _clear() {
+    release();
+    btree()->clear();
+  }
+
+  // Replaces the content of `dst` with a deep copy of this tree, taken as one
+  // structural copy (well-packed nodes, no per-element descent) followed by a
+  // single reference-count pass for object elements. Backs the `snapshot`
+  // methods of the wrapper classes.
+  void copy_elements_into(btree_type& dst) {
+    {
+      gil_release<!std::is_same_v<key_type, PyObject*> &&
+                  !std::is_same_v<mapped_type, PyObject*>>
+          _;
+      dst = *btree();
+    }
+    if constexpr (std::is_same_v<key_type, PyObject*> ||
+                  std::is_same_v<mapped_type, PyObject*>) {
+      gil_guard<> _;
+      for (auto it = dst.begin(); it != dst.end(); ++it) {
+        btree_internal::inc_ref_for_iterator<key_type, mapped_type>(it);
+      }
+    }
+  }
+
+  // Reports the shape of the tree as `(height, node_count, bytes_in_use,
+  // average_fill)`. The absl b-tree does not expose its node structure, so
+  // the node count and footprint come from the node pool's counters (one
+  // allocation per node) and the height is estimated from the average node
+  // occupancy — exact enough to correlate a latency spike with a degraded
+  // shape after churn. Leaf and internal nodes are not distinguishable from
+  // the outside; the node count covers both.
+  std::tuple<size_t, size_t, size_t, double> tree_stats() {
+    const auto& stats = *btree()->get_allocator().stats();
+    const size_t node_count =
+        stats.allocations_in_use.load(std::memory_order_relaxed);
+    const size_t bytes_in_use =
+        stats.bytes_in_use.load(std::memory_order_relaxed);
+    const size_t count = btree()->size();
+    size_t height = 0;
+    double average_fill = 0.0;
+    if (count > 0 && node_count > 0 && bytes_in_use > 0) {
+      const double fanout =
+          std::max(2.0, static_cast<double>(count) / node_count + 1.0);
+      height = static_cast<size_t>(
+          std::ceil(std::log(static_cast<double>(count) + 1.0) /
+                    std::log(fanout)));
+      average_fill = static_cast<double>(count * sizeof(value_type)) /
+                     static_cast<double>(bytes_in_use);
+    }
+    return std::make_tuple(height, node_count, bytes_in_use, average_fill);
+  }
+
+  // Reports `(bytes_in_use, allocations_in_use, average_fill)` for the node
+  // allocations of this tree, where `average_fill` is the fraction of the
+  // allocated bytes that actually holds elements. The numbers come from the
+  // `pool_allocator` every wrapped tree is declared with, so they cover
+  // the b-tree nodes themselves but not Python objects held by reference.
+  std::tuple<size_t, size_t, double> memory_stats() {
+    const auto& stats = *btree()->get_allocator().stats();
+    const size_t bytes_in_use =
+        stats.bytes_in_use.load(std::memory_order_relaxed);
+    const size_t allocations_in_use =
+        stats.allocations_in_use.load(std::memory_order_relaxed);
+    const double average_fill =
+        bytes_in_use == 0
+            ? 0.0
+            : static_cast<double>(btree()->size() * sizeof(value_type)) /
+                  static_cast<double>(bytes_in_use);
+    return std::make_tuple(bytes_in_use, allocations_in_use, average_fill);
+  }
+
+  // Returns the node pool's arena blocks to the OS and reports how many
+  // bytes were released. Blocks interleave live and free node chunks, so the
+  // pool only lets go once no node is live anymore: call this after `clear`
+  // (or after erasing every element) to actually shed the footprint of a
+  // bulk erase; at any other time it is a no-op returning 0.
+  size_t release_memory() {
+    return btree()->get_allocator().get_pool()->release_memory();
+  }
+
+  ~btree_container() { release(); }
+
+ private:
+  bulk_value_type read_snapshot_record(std::istream& in) {
+    if constexpr (std::is_void_v<mapped_type>) {
+      return btree_internal::read_snapshot_field<key_type>(in);
+    } else {
+      key_type key = btree_internal::read_snapshot_field<key_type>(in);
+      mapped_type data = btree_internal::read_snapshot_field<mapped_type>(in);
+      return bulk_value_type(std::move(key), std::move(data));
+    }
+  }
+
+  void release() {
+    if constexpr (std::is_same_v<key_type, PyObject*> ||
+                  std::is_same_v<mapped_type, PyObject*>) {
+      gil_guard<> _;
+      if constexpr (std::is_void_v<mapped_type>) {
+        for (auto&& key : *btree()) {
+          Py_DECREF(key);
+        }
+      } else {
+        for (auto&& [key, value] : *btree()) {
+          if constexpr (std::is_same_v<key_type, PyObject*>) {
+            Py_DECREF(key);
+          }
+          if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+            Py_DECREF(value);
+          }
+        }
+      }
+    }
+  }
+};
+
+template <typename Btree, typename KeyView>
+class btree_multi_container : public btree_container<Btree, KeyView> {
+ public:
+  using btree_type = Btree;
+  using keys_view = KeyView;
+  using iterator = keys_view::iterator;
+  using size_type = btree_type::size_type;
   using key_type = btree_type::key_type;
   using mapped_type = get_mapped_type_or_void_t<btree_type>;
   using value_type = btree_type::value_type;
+  using bulk_value_type =
+      btree_container<btree_type, keys_view>::bulk_value_type;
 
  private:
   using key_arg_type = std::conditional_t<std::is_pointer_v<key_type>, key_type,
@@ -579,6 +1702,18 @@ class btree_multi_container : public btree_container<Btree, KeyView> {
     return iterator(btree()->insert(value));
   }
 
+  // Same as `btree_container::_insert_many` but duplicates are kept, so every
+  // element of `values` ends up in the tree.
+  size_type _insert_many(const std::vector<bulk_value_type>& values) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    for (const bulk_value_type& value : values) {
+      _insert(value);
+    }
+    return values.size();
+  }
+
   size_type _erase(key_arg_type key) {
     if constexpr (!std::is_same_v<key_type, PyObject*> &&
                   !std::is_same_v<mapped_type, PyObject*>) {
@@ -597,31 +1732,199 @@ class btree_multi_container : public btree_container<Btree, KeyView> {
       return removed_count;
     }
   }
+
+  // See `btree_container::_erase_deferred`; every matching element's
+  // references are parked on the pending-decref buffer.
+  size_type _erase_deferred(key_arg_type key) {
+    if constexpr (!std::is_same_v<key_type, PyObject*> &&
+                  !std::is_same_v<mapped_type, PyObject*>) {
+      return btree()->erase(key);
+    } else {
+      size_type removed_count = 0;
+      auto [first, last] = btree()->equal_range(key);
+      for (auto it = first; it != last; ++it) {
+        ++removed_count;
+        btree_internal::defer_decref_for_iterator<key_type, mapped_type>(it);
+      }
+      btree()->erase(first, last);
+      return removed_count;
+    }
+  }
+
+  // Counts the elements with key equal to `key` in one binding crossing,
+  // instead of a lower/upper bound pair plus a distance walk from Python.
+  size_type _count(key_arg_type key) {
+    gil_release<!std::is_same_v<key_type, PyObject*> &&
+                !std::is_same_v<mapped_type, PyObject*>>
+        _;
+    return btree()->count(key);
+  }
+
+  // Materializes every element with key equal to `key` as one batch. For
+  // fan-out keys with thousands of duplicates this is a single crossing
+  // instead of a bound pair plus one iterator call per duplicate.
+  std::vector<bulk_value_type> _equal_range_list(key_arg_type key) {
+    auto [first, last] = btree()->equal_range(key);
+    std::vector<bulk_value_type> result;
+    for (auto it = first; it != last; ++it) {
+      btree_internal::inc_ref_for_iterator<key_type, mapped_type>(it);
+      result.push_back(*it);
+    }
+    return result;
+  }
 };
 
 template <int OpCode>
 class pyobject_cmp {
  public:
   bool operator()(PyObject* lhs, PyObject* rhs) const {
+    // Object keys are almost always homogeneous `int` or `str`; compare those
+    // natively instead of through the generic rich-comparison machinery,
+    // which has to resolve the comparison slot on every call. Subclasses and
+    // ints beyond 64 bits take the generic path so that overridden
+    // comparison methods keep working.
+    if constexpr (OpCode == Py_LT) {
+      if (PyLong_CheckExact(lhs) && PyLong_CheckExact(rhs)) {
+        int lhs_overflow = 0;
+        int rhs_overflow = 0;
+        const long long lhs_value =
+            PyLong_AsLongLongAndOverflow(lhs, &lhs_overflow);
+        const long long rhs_value =
+            PyLong_AsLongLongAndOverflow(rhs, &rhs_overflow);
+        if (lhs_overflow == 0 && rhs_overflow == 0) {
+          return lhs_value < rhs_value;
+        }
+      } else if (PyUnicode_CheckExact(lhs) && PyUnicode_CheckExact(rhs)) {
+        return PyUnicode_Compare(lhs, rhs) < 0;
+      }
+    }
     return PyObject_RichCompareBool(lhs, rhs, OpCode);
   }
 };
 
+// Composite keys whose fields are all (non-bool) integral types of at most
+// 16 bytes combined can be packed into one wide unsigned integer and compared
+// in a single operation.
+template <typename Key>
+struct packed_key_traits {
+  static constexpr bool packable = false;
+};
+
+template <typename... Ts>
+struct packed_key_traits<std::tuple<Ts...>> {
+  static constexpr size_t width = (sizeof(Ts) + ... + size_t{0});
+  static constexpr bool packable =
+      ((std::is_integral_v<Ts> && !std::is_same_v<Ts, bool>) && ...) &&
+      width <= 16;
+};
+
+template <typename A, typename B>
+struct packed_key_traits<std::pair<A, B>> : packed_key_traits<std::tuple<A, B>> {
+};
+
+// Branch-free comparator for all-integral composite keys. `std::tuple`'s
+// lexicographic `operator<` compares field by field with a branch per field;
+// this packs the fields most-significant-first into one `uint64_t` (or
+// `unsigned __int128` for wider keys) with the sign bit of each signed field
+// flipped, so that a single unsigned compare gives the lexicographic order.
+template <typename Key>
+class packed_integral_cmp {
+ public:
+  bool operator()(const Key& lhs, const Key& rhs) const {
+    return pack(lhs) < pack(rhs);
+  }
+
+ private:
+  using packed_type = std::conditional_t<packed_key_traits<Key>::width <= 8,
+                                         uint64_t, unsigned __int128>;
+
+  template <typename T>
+  static packed_type sign_biased(T value) {
+    using unsigned_type = std::make_unsigned_t<T>;
+    auto result = static_cast<unsigned_type>(value);
+    if constexpr (std::is_signed_v<T>) {
+      result ^= unsigned_type{1} << (8 * sizeof(T) - 1);
+    }
+    return result;
+  }
+
+  static packed_type pack(const Key& key) {
+    packed_type packed = 0;
+    std::apply(
+        [&packed](const auto&... fields) {
+          ((packed = (packed << (8 * sizeof(fields))) | sign_biased(fields)),
+           ...);
+        },
+        key);
+    return packed;
+  }
+};
+
+// String keys get the transparent `std::less<>` so that the `string_view`
+// lookup overloads in `btree_container` can probe the tree heterogeneously,
+// without constructing a `std::string` (a heap allocation) per lookup.
+// All-integral composite keys get the branch-free `packed_integral_cmp`.
+template <typename Key>
+using base_comparator = std::conditional_t<
+    std::is_same_v<std::remove_cv_t<Key>, PyObject*>,
+    btree_internal::pyobject_cmp<Py_LT>,
+    std::conditional_t<
+        std::is_same_v<std::remove_cv_t<Key>, std::string>, std::less<>,
+        std::conditional_t<packed_key_traits<std::remove_cv_t<Key>>::packable,
+                           packed_integral_cmp<std::remove_cv_t<Key>>,
+                           std::less<Key>>>>;
+
+#ifdef DJC_BTREE_OP_COUNTERS
+
+// Process-wide tally of key comparisons, live only in builds compiled with
+// -DDJC_BTREE_OP_COUNTERS. One comparison per node level is a good proxy for
+// node traversals, so sampling this counter around a `_find`/`_insert` burst
+// and dividing by the operation count gives the effective descent depth.
+inline std::atomic<uint64_t> comparison_counter{0};
+
+inline uint64_t comparison_count() {
+  return comparison_counter.load(std::memory_order_relaxed);
+}
+
+inline void reset_comparison_count() {
+  comparison_counter.store(0, std::memory_order_relaxed);
+}
+
+// Wraps a comparator with comparison counting. `is_transparent` (if any) is
+// inherited from `Compare`, so heterogeneous lookup keeps working.
+template <typename Compare>
+class counting_cmp : public Compare {
+ public:
+  using Compare::Compare;
+  counting_cmp() = default;
+
+  template <typename Lhs, typename Rhs>
+  bool operator()(const Lhs& lhs, const Rhs& rhs) const {
+    comparison_counter.fetch_add(1, std::memory_order_relaxed);
+    return Compare::operator()(lhs, rhs);
+  }
+};
+
 template <typename Key>
-using default_comparator =
-    std::conditional_t<std::is_same_v<std::remove_cv_t<Key>, PyObject*>,
-                       btree_internal::pyobject_cmp<Py_LT>, std::less<Key>>;
+using default_comparator = counting_cmp<base_comparator<Key>>;
+
+#else
+
+template <typename Key>
+using default_comparator = base_comparator<Key>;
+
+#endif  // DJC_BTREE_OP_COUNTERS
 
 }  // namespace btree_internal
 
 template <typename Key,
           typename Compare = btree_internal::default_comparator<Key>>
 class btree_set
-    : public absl::btree_set<Key, Compare>,
+    : public btree_internal::absl_btree_set<Key, Compare>,
       public btree_internal::btree_container<
-          absl::btree_set<Key, Compare>, btree_set_keys_view<Key, Compare>> {
+          btree_internal::absl_btree_set<Key, Compare>, btree_set_keys_view<Key, Compare>> {
  public:
-  using btree_type = absl::btree_set<Key, Compare>;
+  using btree_type = btree_internal::absl_btree_set<Key, Compare>;
   using key_type = btree_type::key_type;
   using value_type = btree_type::value_type;
   using size_type = btree_type::size_type;
@@ -630,8 +1933,10 @@ class btree_set
 
  private:
   using btree_container =
-      btree_internal::btree_container<absl::btree_set<Key, Compare>,
+      btree_internal::btree_container<btree_internal::absl_btree_set<Key, Compare>,
                                       btree_set_keys_view<Key, Compare>>;
+  using key_arg_type = std::conditional_t<std::is_pointer_v<key_type>, key_type,
+                                          const key_type&>;
 
  public:
   using btree_container::begin;
@@ -640,18 +1945,116 @@ class btree_set
   using keys_view_generator =
       btree_internal::btree_view_generator<btree_set, btree_set_keys_view, Key,
                                            Compare>;
+  using reversed_keys_view_generator = btree_internal::btree_reverse_view_generator<
+      btree_set, btree_set_keys_view, Key, Compare>;
 
   keys_view_generator keys() { return keys_view_generator(*this); }
+  reversed_keys_view_generator reversed_keys() {
+    return reversed_keys_view_generator(*this);
+  }
+
+  // Returns an independent deep copy for consistent reads while the original
+  // keeps changing. This is a single native pass, not O(1): absl's b-tree
+  // nodes are not reference counted, so a true copy-on-write clone would
+  // require forking the container. The structural copy runs at memcpy-like
+  // speed with the GIL released for native types, which removes the
+  // GIL-held Python iteration this replaces.
+  std::unique_ptr<btree_set> snapshot() {
+    auto result = std::make_unique<btree_set>();
+    btree_container::copy_elements_into(*static_cast<btree_type*>(result.get()));
+    return result;
+  }
+
+  // Non-destructive set algebra against another set of the same type. All
+  // three run a single co-walk of the two sorted sequences with end-hinted
+  // inserts into the result, so they are linear in the input sizes and never
+  // re-enter Python except to count references on `object` keys.
+  std::unique_ptr<btree_set> union_(btree_set& rhs) {
+    auto result = std::make_unique<btree_set>();
+    gil_release<!std::is_same_v<key_type, PyObject*>> _;
+    const Compare comp = btree_type::key_comp();
+    auto it = btree_type::begin();
+    auto rhs_it = static_cast<btree_type&>(rhs).begin();
+    while (it != btree_type::end() &&
+           rhs_it != static_cast<btree_type&>(rhs).end()) {
+      if (comp(*it, *rhs_it)) {
+        result->append_key(*it++);
+      } else if (comp(*rhs_it, *it)) {
+        result->append_key(*rhs_it++);
+      } else {
+        result->append_key(*it++);
+        ++rhs_it;
+      }
+    }
+    for (; it != btree_type::end(); ++it) {
+      result->append_key(*it);
+    }
+    for (; rhs_it != static_cast<btree_type&>(rhs).end(); ++rhs_it) {
+      result->append_key(*rhs_it);
+    }
+    return result;
+  }
+
+  std::unique_ptr<btree_set> intersection(btree_set& rhs) {
+    auto result = std::make_unique<btree_set>();
+    gil_release<!std::is_same_v<key_type, PyObject*>> _;
+    const Compare comp = btree_type::key_comp();
+    auto it = btree_type::begin();
+    auto rhs_it = static_cast<btree_type&>(rhs).begin();
+    while (it != btree_type::end() &&
+           rhs_it != static_cast<btree_type&>(rhs).end()) {
+      if (comp(*it, *rhs_it)) {
+        ++it;
+      } else if (comp(*rhs_it, *it)) {
+        ++rhs_it;
+      } else {
+        result->append_key(*it++);
+        ++rhs_it;
+      }
+    }
+    return result;
+  }
+
+  std::unique_ptr<btree_set> difference(btree_set& rhs) {
+    auto result = std::make_unique<btree_set>();
+    gil_release<!std::is_same_v<key_type, PyObject*>> _;
+    const Compare comp = btree_type::key_comp();
+    auto it = btree_type::begin();
+    auto rhs_it = static_cast<btree_type&>(rhs).begin();
+    while (it != btree_type::end() &&
+           rhs_it != static_cast<btree_type&>(rhs).end()) {
+      if (comp(*it, *rhs_it)) {
+        result->append_key(*it++);
+      } else if (comp(*rhs_it, *it)) {
+        ++rhs_it;
+      } else {
+        ++it;
+        ++rhs_it;
+      }
+    }
+    for (; it != btree_type::end(); ++it) {
+      result->append_key(*it);
+    }
+    return result;
+  }
+
+ private:
+  void append_key(key_arg_type key) {
+    btree_type::insert(btree_type::end(), key);
+    if constexpr (std::is_same_v<key_type, PyObject*>) {
+      Py_INCREF(key);
+    }
+  }
 };
 
 template <typename Key,
           typename Compare = btree_internal::default_comparator<Key>>
-class btree_multiset : public absl::btree_multiset<Key, Compare>,
+class btree_multiset : public btree_internal::absl_btree_multiset<Key, Compare>,
                        public btree_internal::btree_multi_container<
-                           absl::btree_multiset<Key, Compare>,
+                           btree_internal::absl_btree_multiset<Key, Compare>,
                            btree_multiset_keys_view<Key, Compare>> {
  public:
-  using btree_type = absl::btree_multiset<Key, Compare>;
+  using btree_type = btree_internal::absl_btree_multiset<Key, Compare>;
   using key_type = btree_type::key_type;
   using value_type = btree_type::value_type;
   using size_type = btree_type::size_type;
@@ -660,7 +2063,7 @@ class btree_multiset : public absl::btree_multiset<Key, Compare>,
 
  private:
   using btree_container = btree_internal::btree_multi_container<
-      absl::btree_multiset<Key, Compare>,
+      btree_internal::absl_btree_multiset<Key, Compare>,
       btree_multiset_keys_view<Key, Compare>>;
 
  public:
@@ -669,18 +2072,31 @@ class btree_multiset : public absl::btree_multiset<Key, Compare>,
 
   using keys_view_generator = btree_internal::btree_view_generator<
       btree_multiset, btree_multiset_keys_view, Key, Compare>;
+  using reversed_keys_view_generator =
+      btree_internal::btree_reverse_view_generator<
+          btree_multiset, btree_multiset_keys_view, Key, Compare>;
 
   keys_view_generator keys() { return keys_view_generator(*this); }
+  reversed_keys_view_generator reversed_keys() {
+    return reversed_keys_view_generator(*this);
+  }
+
+  // See `btree_set::snapshot`.
+  std::unique_ptr<btree_multiset> snapshot() {
+    auto result = std::make_unique<btree_multiset>();
+    btree_container::copy_elements_into(*static_cast<btree_type*>(result.get()));
+    return result;
+  }
 };
 
 template <typename Key, typename Data,
           typename Compare = btree_internal::default_comparator<Key>>
-class btree_map : public absl::btree_map<Key, Data, Compare>,
+class btree_map : public btree_internal::absl_btree_map<Key, Data, Compare>,
                   public btree_internal::btree_container<
-                      absl::btree_map<Key, Data, Compare>,
+                      btree_internal::absl_btree_map<Key, Data, Compare>,
                       btree_map_keys_view<Key, Data, Compare>> {
  public:
-  using btree_type = absl::btree_map<Key, Data, Compare>;
+  using btree_type = btree_internal::absl_btree_map<Key, Data, Compare>;
   using key_type = btree_type::key_type;
   using mapped_type = btree_type::mapped_type;
   using value_type = btree_type::value_type;
@@ -690,13 +2106,21 @@ class btree_map : public absl::btree_map<Key, Data, Compare>,
 
  private:
   using btree_container =
-      btree_internal::btree_container<absl::btree_map<Key, Data, Compare>,
+      btree_internal::btree_container<btree_internal::absl_btree_map<Key, Data, Compare>,
                                       btree_map_keys_view<Key, Data, Compare>>;
   using key_arg_type = std::conditional_t<std::is_pointer_v<key_type>, key_type,
                                           const key_type&>;
   using mapped_arg_type = std::conditional_t<std::is_pointer_v<mapped_type>,
                                              mapped_type, const mapped_type&>;
 
+  static mapped_type default_mapped_value() {
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      return Py_None;
+    } else {
+      return mapped_type{};
+    }
+  }
+
  public:
   using btree_container::begin;
   using btree_container::end;
@@ -710,10 +2134,39 @@ class btree_map : public absl::btree_map<Key, Data, Compare>,
   using items_view_generator =
       btree_internal::btree_view_generator<btree_map, btree_map_items_view, Key,
                                            Data, Compare>;
+  using reversed_keys_view_generator =
+      btree_internal::btree_reverse_view_generator<btree_map,
+                                                   btree_map_keys_view, Key,
+                                                   Data, Compare>;
+  using reversed_values_view_generator =
+      btree_internal::btree_reverse_view_generator<btree_map,
+                                                   btree_map_values_view, Key,
+                                                   Data, Compare>;
+  using reversed_items_view_generator =
+      btree_internal::btree_reverse_view_generator<btree_map,
+                                                   btree_map_items_view, Key,
+                                                   Data, Compare>;
 
   keys_view_generator keys() { return keys_view_generator(*this); }
   values_view_generator values() { return values_view_generator(*this); }
   items_view_generator items() { return items_view_generator(*this); }
+  reversed_keys_view_generator reversed_keys() {
+    return reversed_keys_view_generator(*this);
+  }
+  reversed_values_view_generator reversed_values() {
+    return reversed_values_view_generator(*this);
+  }
+  reversed_items_view_generator reversed_items() {
+    return reversed_items_view_generator(*this);
+  }
+
+  // See `btree_set::snapshot`. The snapshot serves the same
+  // `keys()`/`values()`/`items()` generators as the live map.
+  std::unique_ptr<btree_map> snapshot() {
+    auto result = std::make_unique<btree_map>();
+    btree_container::copy_elements_into(*static_cast<btree_type*>(result.get()));
+    return result;
+  }
 
   std::pair<iterator, bool> insert_or_assign(key_arg_type key,
                                              mapped_arg_type data) {
@@ -734,13 +2187,164 @@ class btree_map : public absl::btree_map<Key, Data, Compare>,
     return std::make_pair(iterator(it), inserted);
   }
 
-  mapped_type get_item(key_arg_type key) {
-    auto [it, inserted] = btree_type::try_emplace(key);
-    gil_guard<!std::is_same_v<key_type, PyObject*> &&
-              std::is_same_v<mapped_type, PyObject*>>
-        _;
-    if (inserted) {
-      if constexpr (std::is_same_v<key_type, PyObject*>) {
+  // Bulk counterpart of `insert_or_assign`, applied to every `(key, value)`
+  // pair of `values` without re-entering Python in between. Returns the number
+  // of keys that were newly inserted (as opposed to assigned).
+  size_type insert_or_assign_many(
+      const std::vector<std::pair<key_type, mapped_type>>& values) {
+    size_type inserted_count = 0;
+    for (const auto& [key, data] : values) {
+      if (insert_or_assign(key, data).second) {
+        ++inserted_count;
+      }
+    }
+    return inserted_count;
+  }
+
+  // Range aggregation kernels for arithmetic values: the accumulation walks
+  // the contiguous leaf arrays entirely in C++ (where the compiler can
+  // vectorize it) instead of pulling every element into Python first. All
+  // three aggregate over the key range `[lo, hi)`; `min_range`/`max_range`
+  // raise on an empty range. Use `count_range` for plain counting.
+  mapped_type sum_range(key_arg_type lo, key_arg_type hi)
+    requires(std::is_arithmetic_v<Data>)
+  {
+    gil_release<!std::is_same_v<key_type, PyObject*>> _;
+    mapped_type total{};
+    auto [it, last] = btree_container::range_bounds(lo, hi);
+    for (; it != last; ++it) {
+      total += it->second;
+    }
+    return total;
+  }
+
+  mapped_type min_range(key_arg_type lo, key_arg_type hi)
+    requires(std::is_arithmetic_v<Data>)
+  {
+    gil_release<!std::is_same_v<key_type, PyObject*>> _;
+    auto [it, last] = btree_container::range_bounds(lo, hi);
+    if (it == last) {
+      throw std::out_of_range("min_range over an empty key range");
+    }
+    mapped_type result = it->second;
+    for (++it; it != last; ++it) {
+      result = std::min(result, it->second);
+    }
+    return result;
+  }
+
+  mapped_type max_range(key_arg_type lo, key_arg_type hi)
+    requires(std::is_arithmetic_v<Data>)
+  {
+    gil_release<!std::is_same_v<key_type, PyObject*>> _;
+    auto [it, last] = btree_container::range_bounds(lo, hi);
+    if (it == last) {
+      throw std::out_of_range("max_range over an empty key range");
+    }
+    mapped_type result = it->second;
+    for (++it; it != last; ++it) {
+      result = std::max(result, it->second);
+    }
+    return result;
+  }
+
+  // Bulk counterpart of `dict.setdefault`: inserts `(key, value)` only for
+  // keys not already present, leaving existing values untouched, all within
+  // one binding crossing. Returns the number of keys inserted.
+  size_type setdefault_many(
+      const std::vector<std::pair<key_type, mapped_type>>& values) {
+    size_type inserted_count = 0;
+    for (const auto& [key, data] : values) {
+      auto [it, inserted] = btree_type::try_emplace(key, data);
+      if (inserted) {
+        ++inserted_count;
+        if constexpr (std::is_same_v<key_type, PyObject*>) {
+          Py_INCREF(key);
+        }
+        if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+          Py_INCREF(it->second);
+        }
+      }
+    }
+    return inserted_count;
+  }
+
+  // Writes the map as a frozen, mmap-ready image for `frozen_btree_map`:
+  // magic, element count, the dense sorted key array, padding up to 8-byte
+  // alignment, then the dense value array. Only available for arithmetic key
+  // and value types, whose elements have a fixed on-disk width.
+  void freeze(const std::string& path)
+    requires(std::is_arithmetic_v<Key> && std::is_arithmetic_v<Data>)
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      throw std::runtime_error("cannot open frozen index file for writing: " +
+                               path);
+    }
+    out.write(btree_internal::kFrozenMagic, btree_internal::kFrozenMagicSize);
+    const uint64_t count = btree_type::size();
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    for (auto it = btree_type::begin(); it != btree_type::end(); ++it) {
+      out.write(reinterpret_cast<const char*>(&it->first), sizeof(it->first));
+    }
+    const size_t keys_end =
+        btree_internal::kFrozenHeaderSize + count * sizeof(key_type);
+    for (size_t i = keys_end; i < btree_internal::align_to_8(keys_end); ++i) {
+      out.put('\0');
+    }
+    for (auto it = btree_type::begin(); it != btree_type::end(); ++it) {
+      out.write(reinterpret_cast<const char*>(&it->second), sizeof(it->second));
+    }
+    if (!out) {
+      throw std::runtime_error("failed to write frozen index file: " + path);
+    }
+  }
+
+  // Read-only lookup: returns the value for `key`, or `default_value` when
+  // the key is missing, without ever mutating the tree. `__getitem__` keeps
+  // its dict-on-steroids behavior of inserting a default on a miss, which
+  // existing callers rely on; read-mostly paths should use `get`, whose
+  // probes touch zero allocation.
+  mapped_type get(key_arg_type key,
+                  mapped_arg_type default_value = default_mapped_value()) {
+    auto it = btree_type::find(key);
+    gil_guard<!std::is_same_v<key_type, PyObject*> &&
+              std::is_same_v<mapped_type, PyObject*>>
+        _;
+    if (it == btree_type::end()) {
+      if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+        Py_INCREF(default_value);
+      }
+      return default_value;
+    }
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      Py_INCREF(it->second);
+    }
+    return it->second;
+  }
+
+  // Like `get` but a missing key raises instead of producing a default.
+  mapped_type strict_get(key_arg_type key) {
+    auto it = btree_type::find(key);
+    if (it == btree_type::end()) {
+      throw std::out_of_range("key not found");
+    }
+    gil_guard<!std::is_same_v<key_type, PyObject*> &&
+              std::is_same_v<mapped_type, PyObject*>>
+        _;
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      Py_INCREF(it->second);
+    }
+    return it->second;
+  }
+
+  mapped_type get_item(key_arg_type key) {
+    auto [it, inserted] = btree_type::try_emplace(key);
+    gil_guard<!std::is_same_v<key_type, PyObject*> &&
+              std::is_same_v<mapped_type, PyObject*>>
+        _;
+    if (inserted) {
+      if constexpr (std::is_same_v<key_type, PyObject*>) {
         Py_INCREF(key);
       }
       if constexpr (std::is_same_v<mapped_type, PyObject*>) {
@@ -757,12 +2361,12 @@ class btree_map : public absl::btree_map<Key, Data, Compare>,
 
 template <typename Key, typename Data,
           typename Compare = btree_internal::default_comparator<Key>>
-class btree_multimap : public absl::btree_multimap<Key, Data, Compare>,
+class btree_multimap : public btree_internal::absl_btree_multimap<Key, Data, Compare>,
                        public btree_internal::btree_multi_container<
-                           absl::btree_multimap<Key, Data, Compare>,
+                           btree_internal::absl_btree_multimap<Key, Data, Compare>,
                            btree_multimap_keys_view<Key, Data, Compare>> {
  public:
-  using btree_type = absl::btree_multimap<Key, Data, Compare>;
+  using btree_type = btree_internal::absl_btree_multimap<Key, Data, Compare>;
   using key_type = btree_type::key_type;
   using mapped_type = btree_type::mapped_type;
   using value_type = btree_type::value_type;
@@ -772,7 +2376,7 @@ class btree_multimap : public absl::btree_multimap<Key, Data, Compare>,
 
  private:
   using btree_container = btree_internal::btree_multi_container<
-      absl::btree_multimap<Key, Data, Compare>,
+      btree_internal::absl_btree_multimap<Key, Data, Compare>,
       btree_multimap_keys_view<Key, Data, Compare>>;
 
  public:
@@ -785,10 +2389,644 @@ class btree_multimap : public absl::btree_multimap<Key, Data, Compare>,
       btree_multimap, btree_multimap_values_view, Key, Data, Compare>;
   using items_view_generator = btree_internal::btree_view_generator<
       btree_multimap, btree_multimap_items_view, Key, Data, Compare>;
+  using reversed_keys_view_generator =
+      btree_internal::btree_reverse_view_generator<
+          btree_multimap, btree_multimap_keys_view, Key, Data, Compare>;
+  using reversed_values_view_generator =
+      btree_internal::btree_reverse_view_generator<
+          btree_multimap, btree_multimap_values_view, Key, Data, Compare>;
+  using reversed_items_view_generator =
+      btree_internal::btree_reverse_view_generator<
+          btree_multimap, btree_multimap_items_view, Key, Data, Compare>;
 
   keys_view_generator keys() { return keys_view_generator(*this); }
   values_view_generator values() { return values_view_generator(*this); }
   items_view_generator items() { return items_view_generator(*this); }
+  reversed_keys_view_generator reversed_keys() {
+    return reversed_keys_view_generator(*this);
+  }
+  reversed_values_view_generator reversed_values() {
+    return reversed_values_view_generator(*this);
+  }
+  reversed_items_view_generator reversed_items() {
+    return reversed_items_view_generator(*this);
+  }
+
+  // See `btree_set::snapshot`.
+  std::unique_ptr<btree_multimap> snapshot() {
+    auto result = std::make_unique<btree_multimap>();
+    btree_container::copy_elements_into(*static_cast<btree_type*>(result.get()));
+    return result;
+  }
+};
+
+// A read-only, memory-mapped companion to `btree_map` for arithmetic key and
+// value types. `btree_map::freeze` lays the sorted keys and values out as two
+// dense fixed-width arrays; this class maps that file and binary-searches the
+// key array in place, which replaces the pointer-based node layout with pure
+// offsets. Opening an index is a single `mmap` call, the kernel shares the
+// pages read-only across forked workers, and nothing is rebuilt at startup.
+//
+// Mutating methods are deliberately absent; rebuild and re-freeze to update.
+template <typename Key, typename Data,
+          typename Compare = btree_internal::default_comparator<Key>>
+  requires(std::is_arithmetic_v<Key> && std::is_arithmetic_v<Data>)
+class frozen_btree_map {
+ public:
+  using key_type = Key;
+  using mapped_type = Data;
+  using size_type = size_t;
+
+  explicit frozen_btree_map(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("cannot open frozen index file: " + path);
+    }
+    const off_t file_size = ::lseek(fd, 0, SEEK_END);
+    if (file_size < static_cast<off_t>(btree_internal::kFrozenHeaderSize)) {
+      ::close(fd);
+      throw std::runtime_error("not a pybtree frozen index file: " + path);
+    }
+    mapping_size_ = file_size;
+    mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+      throw std::runtime_error("failed to mmap frozen index file: " + path);
+    }
+    const char* base = static_cast<const char*>(mapping_);
+    uint64_t count;
+    std::memcpy(&count, base + btree_internal::kFrozenMagicSize,
+                sizeof(count));
+    const size_t values_offset = btree_internal::align_to_8(
+        btree_internal::kFrozenHeaderSize + count * sizeof(key_type));
+    if (std::memcmp(base, btree_internal::kFrozenMagic,
+                    btree_internal::kFrozenMagicSize) != 0 ||
+        mapping_size_ != values_offset + count * sizeof(mapped_type)) {
+      ::munmap(mapping_, mapping_size_);
+      throw std::runtime_error("not a pybtree frozen index file: " + path);
+    }
+    count_ = count;
+    keys_ = reinterpret_cast<const key_type*>(
+        base + btree_internal::kFrozenHeaderSize);
+    values_ = reinterpret_cast<const mapped_type*>(base + values_offset);
+  }
+
+  frozen_btree_map(const frozen_btree_map&) = delete;
+  frozen_btree_map& operator=(const frozen_btree_map&) = delete;
+
+  ~frozen_btree_map() { ::munmap(mapping_, mapping_size_); }
+
+  size_type size() const { return count_; }
+
+  bool empty() const { return count_ == 0; }
+
+  bool not_empty() const { return !empty(); }
+
+  bool _contains(key_type key) const { return find_index(key) != count_; }
+
+  // Read-only lookup; returns `default_value` when the key is absent.
+  mapped_type get(key_type key, mapped_type default_value = {}) const {
+    const size_type index = find_index(key);
+    return index == count_ ? default_value : values_[index];
+  }
+
+  // Same contract as `btree_container::_range`: all elements with key in
+  // `[lo, hi)` as one batch, optionally capped at `limit` elements.
+  std::vector<std::pair<key_type, mapped_type>> _range(
+      key_type lo, key_type hi, size_type limit = 0) const {
+    std::vector<std::pair<key_type, mapped_type>> result;
+    const key_type* first = std::lower_bound(keys_, keys_ + count_, lo, Compare{});
+    const key_type* last = std::lower_bound(first, keys_ + count_, hi, Compare{});
+    for (const key_type* it = first; it != last; ++it) {
+      if (limit != 0 && result.size() == limit) {
+        break;
+      }
+      result.emplace_back(*it, values_[it - keys_]);
+    }
+    return result;
+  }
+
+ private:
+  // Index of `key` in the key array, or `count_` if absent.
+  size_type find_index(key_type key) const {
+    const key_type* it =
+        std::lower_bound(keys_, keys_ + count_, key, Compare{});
+    if (it == keys_ + count_ || Compare{}(key, *it)) {
+      return count_;
+    }
+    return it - keys_;
+  }
+
+  void* mapping_;
+  size_t mapping_size_;
+  const key_type* keys_;
+  const mapped_type* values_;
+  size_type count_;
+};
+
+// An opt-in, read-only companion to string-keyed maps that front-codes its
+// keys: keys are grouped into blocks of `kBlockSize`, the first key of each
+// block is stored in full and every following key as a (shared-prefix
+// length, suffix) pair, all in one contiguous byte buffer. URL-like key sets
+// with long common prefixes shrink by more than half, and the shorter stored
+// records put more keys on each cache line during lookups. A probe
+// binary-searches the block heads and decodes at most one block; full
+// strings are reconstructed only at the Python boundary.
+//
+// Built in one pass from items sorted by unique key (e.g. a map's `range`
+// output). Mutating methods are deliberately absent; rebuild to update.
+template <typename Data>
+class compressed_string_map {
+ public:
+  using key_type = std::string;
+  using mapped_type = Data;
+  using size_type = size_t;
+
+  static constexpr size_type kBlockSize = 16;
+  // Prefix and suffix lengths are stored as `uint16_t`.
+  static constexpr size_type kMaxKeyLength = 65535;
+
+ private:
+  using mapped_arg_type = std::conditional_t<std::is_pointer_v<mapped_type>,
+                                             mapped_type, const mapped_type&>;
+
+  static mapped_type default_mapped_value() {
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      return Py_None;
+    } else {
+      return mapped_type{};
+    }
+  }
+
+ public:
+  explicit compressed_string_map(
+      const std::vector<std::pair<std::string, mapped_type>>& items) {
+    // Validate before encoding, so that a throw cannot leak references taken
+    // by the encoding pass below.
+    for (size_type i = 0; i < items.size(); ++i) {
+      if (items[i].first.size() > kMaxKeyLength) {
+        throw std::invalid_argument(
+            "compressed map keys are limited to 65535 bytes");
+      }
+      if (i > 0 && items[i - 1].first >= items[i].first) {
+        throw std::invalid_argument(
+            "items must be sorted by strictly increasing key");
+      }
+    }
+    count_ = items.size();
+    values_.reserve(count_);
+    gil_guard<std::is_same_v<mapped_type, PyObject*>> _;
+    std::string_view previous;
+    for (const auto& [key, value] : items) {
+      if (values_.size() % kBlockSize == 0) {
+        block_offsets_.push_back(encoded_.size());
+        append_entry(0, key);
+      } else {
+        size_type lcp = 0;
+        const size_type bound = std::min(previous.size(), key.size());
+        while (lcp < bound && previous[lcp] == key[lcp]) {
+          ++lcp;
+        }
+        append_entry(lcp, std::string_view(key).substr(lcp));
+      }
+      raw_key_bytes_ += key.size();
+      previous = key;
+      if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+        Py_INCREF(value);
+      }
+      values_.push_back(value);
+    }
+  }
+
+  compressed_string_map(const compressed_string_map&) = delete;
+  compressed_string_map& operator=(const compressed_string_map&) = delete;
+
+  ~compressed_string_map() {
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      gil_guard<> _;
+      for (PyObject* value : values_) {
+        Py_DECREF(value);
+      }
+    }
+  }
+
+  size_type size() const { return count_; }
+
+  bool empty() const { return count_ == 0; }
+
+  bool not_empty() const { return !empty(); }
+
+  bool _contains(std::string_view key) const {
+    return find_index(key) != count_;
+  }
+
+  // Read-only lookup; returns `default_value` when the key is absent. Same
+  // reference contract as `btree_map::get`.
+  mapped_type get(std::string_view key,
+                  mapped_arg_type default_value = default_mapped_value()) {
+    const size_type index = find_index(key);
+    gil_guard<std::is_same_v<mapped_type, PyObject*>> _;
+    if (index == count_) {
+      if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+        Py_INCREF(default_value);
+      }
+      return default_value;
+    }
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      Py_INCREF(values_[index]);
+    }
+    return values_[index];
+  }
+
+  // Same contract as `btree_container::_range`: all elements with key in
+  // `[lo, hi)` as one batch, optionally capped at `limit` elements.
+  std::vector<std::pair<std::string, mapped_type>> _range(
+      std::string_view lo, std::string_view hi, size_type limit = 0) const {
+    std::vector<std::pair<std::string, mapped_type>> result;
+    const size_type first = lower_bound_index(lo);
+    if (first == count_) {
+      return result;
+    }
+    for (walker w(*this, first / kBlockSize); w.next();) {
+      if (w.index() < first) {
+        continue;
+      }
+      if (w.key() >= hi || (limit != 0 && result.size() == limit)) {
+        break;
+      }
+      if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+        Py_INCREF(values_[w.index()]);
+      }
+      result.emplace_back(w.key(), values_[w.index()]);
+    }
+    return result;
+  }
+
+  // Materializes the whole map as one sorted batch.
+  std::vector<std::pair<std::string, mapped_type>> _items_list() const {
+    std::vector<std::pair<std::string, mapped_type>> result;
+    result.reserve(count_);
+    for (walker w(*this, 0); w.next();) {
+      if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+        Py_INCREF(values_[w.index()]);
+      }
+      result.emplace_back(w.key(), values_[w.index()]);
+    }
+    return result;
+  }
+
+  // Returns `(stored_key_bytes, raw_key_bytes)`: what the front-coded buffer
+  // occupies versus what the same keys would occupy stored in full.
+  std::pair<size_type, size_type> memory_stats() const {
+    return {encoded_.size() + block_offsets_.size() * sizeof(size_type),
+            raw_key_bytes_};
+  }
+
+ private:
+  // Sequential decoder over the encoded buffer, starting at the first entry
+  // of `block`. Blocks are laid out back to back, so decoding runs through
+  // block boundaries (where the prefix length resets to zero) transparently.
+  class walker {
+   public:
+    walker(const compressed_string_map& map, size_type block)
+        : map_(&map),
+          next_index_(block * kBlockSize),
+          cursor_(map.encoded_.data() + map.block_offsets_[block]) {}
+
+    bool next() {
+      if (next_index_ >= map_->count_) {
+        return false;
+      }
+      uint16_t prefix_length;
+      uint16_t suffix_length;
+      std::memcpy(&prefix_length, cursor_, sizeof(prefix_length));
+      std::memcpy(&suffix_length, cursor_ + sizeof(prefix_length),
+                  sizeof(suffix_length));
+      cursor_ += sizeof(prefix_length) + sizeof(suffix_length);
+      key_.resize(prefix_length);
+      key_.append(cursor_, suffix_length);
+      cursor_ += suffix_length;
+      index_ = next_index_++;
+      return true;
+    }
+
+    const std::string& key() const { return key_; }
+    size_type index() const { return index_; }
+
+   private:
+    const compressed_string_map* map_;
+    size_type index_ = 0;
+    size_type next_index_;
+    const char* cursor_;
+    std::string key_;
+  };
+
+  void append_entry(size_type prefix_length, std::string_view suffix) {
+    const uint16_t lcp = prefix_length;
+    const uint16_t length = suffix.size();
+    encoded_.append(reinterpret_cast<const char*>(&lcp), sizeof(lcp));
+    encoded_.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    encoded_.append(suffix);
+  }
+
+  // The full first key of `block`, viewed in place.
+  std::string_view head(size_type block) const {
+    const char* entry = encoded_.data() + block_offsets_[block];
+    uint16_t length;
+    std::memcpy(&length, entry + sizeof(uint16_t), sizeof(length));
+    return std::string_view(entry + 2 * sizeof(uint16_t), length);
+  }
+
+  // The first block whose head key is greater than `key`; every key greater
+  // than `key` lives at or after that block, every key not greater than
+  // `key` strictly before it... except inside block `result - 1`.
+  size_type first_block_after(std::string_view key) const {
+    size_type lo = 0;
+    size_type hi = block_offsets_.size();
+    while (lo < hi) {
+      const size_type mid = lo + (hi - lo) / 2;
+      if (head(mid) <= key) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  // Index of `key`, or `count_` if absent.
+  size_type find_index(std::string_view key) const {
+    const size_type block = first_block_after(key);
+    if (block == 0) {
+      return count_;
+    }
+    const size_type block_last = std::min(count_, block * kBlockSize);
+    for (walker w(*this, block - 1); w.next() && w.index() < block_last;) {
+      if (w.key() == key) {
+        return w.index();
+      }
+      if (w.key() > key) {
+        break;
+      }
+    }
+    return count_;
+  }
+
+  // Index of the first entry with key not less than `key`, or `count_`.
+  size_type lower_bound_index(std::string_view key) const {
+    const size_type block = first_block_after(key);
+    if (block == 0) {
+      return 0;
+    }
+    const size_type block_last = std::min(count_, block * kBlockSize);
+    for (walker w(*this, block - 1); w.next() && w.index() < block_last;) {
+      if (w.key() >= key) {
+        return w.index();
+      }
+    }
+    return block_last;
+  }
+
+  std::string encoded_;
+  std::vector<size_type> block_offsets_;
+  std::vector<mapped_type> values_;
+  size_type count_ = 0;
+  size_type raw_key_bytes_ = 0;
+};
+
+// A sharded ordered map for multi-core writers. The key space is partitioned
+// by hash across `kNumShards` independent `absl::btree_map` shards, each
+// guarded by its own mutex, so writers that run with the GIL released (all
+// native-typed operations do) only contend when they hit the same shard.
+//
+// It cannot reuse `btree_internal::btree_container`, which assumes a single
+// underlying tree sharing the object's address, so no iterators or views are
+// exposed; ordered cross-shard iteration is materialized through
+// `_items_list`, which merges the sorted shards into one batch.
+template <typename Key, typename Data,
+          typename Compare = btree_internal::default_comparator<Key>>
+class btree_concurrent_map {
+ public:
+  using btree_type = btree_internal::absl_btree_map<Key, Data, Compare>;
+  using key_type = btree_type::key_type;
+  using mapped_type = btree_type::mapped_type;
+  using value_type = btree_type::value_type;
+  using size_type = btree_type::size_type;
+  using bulk_value_type = std::pair<key_type, mapped_type>;
+
+  // A power of two so the shard selection compiles down to a mask.
+  static constexpr size_t kNumShards = 16;
+
+ private:
+  static constexpr bool is_native = !std::is_same_v<Key, PyObject*> &&
+                                    !std::is_same_v<Data, PyObject*>;
+
+  using key_arg_type = std::conditional_t<std::is_pointer_v<key_type>, key_type,
+                                          const key_type&>;
+  using value_arg_type = std::conditional_t<std::is_pointer_v<value_type>,
+                                            value_type, const value_type&>;
+  using mapped_arg_type = std::conditional_t<std::is_pointer_v<mapped_type>,
+                                             mapped_type, const mapped_type&>;
+
+  static mapped_type default_mapped_value() {
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      return Py_None;
+    } else {
+      return mapped_type{};
+    }
+  }
+
+ public:
+  btree_concurrent_map() = default;
+
+  btree_concurrent_map(const btree_concurrent_map&) = delete;
+  btree_concurrent_map& operator=(const btree_concurrent_map&) = delete;
+
+  ~btree_concurrent_map() { release(); }
+
+  bool empty() { return size() == 0; }
+
+  bool not_empty() { return !empty(); }
+
+  size_type size() {
+    gil_release<is_native> _;
+    size_type total = 0;
+    for (shard& s : shards_) {
+      absl::MutexLock lock(&s.mutex);
+      total += s.map.size();
+    }
+    return total;
+  }
+
+  bool _contains(key_arg_type key) {
+    const size_t index = shard_index(key);
+    gil_release<is_native> _;
+    shard& s = shards_[index];
+    absl::MutexLock lock(&s.mutex);
+    return s.map.contains(key);
+  }
+
+  // Read-only lookup under the key's shard lock: returns the value for
+  // `key`, or `default_value` when the key is missing. Same reference
+  // contract as `btree_map::get`.
+  mapped_type get(key_arg_type key,
+                  mapped_arg_type default_value = default_mapped_value()) {
+    const size_t index = shard_index(key);
+    gil_release<is_native> _;
+    shard& s = shards_[index];
+    absl::MutexLock lock(&s.mutex);
+    auto it = s.map.find(key);
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      gil_guard<> unused;
+      Py_INCREF(it == s.map.end() ? default_value : it->second);
+    }
+    if (it == s.map.end()) {
+      return default_value;
+    }
+    return it->second;
+  }
+
+  bool _insert(value_arg_type value) {
+    const size_t index = shard_index(value.first);
+    gil_release<is_native> _;
+    return insert_into(shards_[index], value);
+  }
+
+  size_type _insert_many(const std::vector<bulk_value_type>& values) {
+    // Shard indices are computed up front: for `PyObject*` keys the hashing
+    // must happen while the GIL is still held.
+    std::vector<size_t> indices;
+    indices.reserve(values.size());
+    for (const bulk_value_type& value : values) {
+      indices.push_back(shard_index(value.first));
+    }
+    gil_release<is_native> _;
+    size_type inserted_count = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+      if (insert_into(shards_[indices[i]], values[i])) {
+        ++inserted_count;
+      }
+    }
+    return inserted_count;
+  }
+
+  bool insert_or_assign(key_arg_type key, mapped_arg_type data) {
+    const size_t index = shard_index(key);
+    if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+      Py_INCREF(data);
+    }
+    gil_release<is_native> _;
+    shard& s = shards_[index];
+    absl::MutexLock lock(&s.mutex);
+    auto [it, inserted] = s.map.try_emplace(key, data);
+    if (inserted) {
+      if constexpr (std::is_same_v<key_type, PyObject*>) {
+        Py_INCREF(key);
+      }
+    } else {
+      if constexpr (std::is_same_v<mapped_type, PyObject*>) {
+        Py_DECREF(it->second);
+      }
+      it->second = data;
+    }
+    return inserted;
+  }
+
+  size_type _erase(key_arg_type key) {
+    const size_t index = shard_index(key);
+    gil_release<is_native> _;
+    shard& s = shards_[index];
+    absl::MutexLock lock(&s.mutex);
+    if constexpr (is_native) {
+      return s.map.erase(key);
+    } else if (auto it = s.map.find(key); it == s.map.end()) {
+      return 0;
+    } else {
+      {
+        gil_guard<> unused;
+        btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+      }
+      s.map.erase(it);
+      return 1;
+    }
+  }
+
+  // Materializes the whole map, ordered by key across all shards, as one
+  // batch. Each shard is already sorted; the shards are concatenated under
+  // their locks and merged by key afterwards, outside any lock.
+  std::vector<bulk_value_type> _items_list() {
+    gil_release<is_native> _;
+    std::vector<bulk_value_type> result;
+    for (shard& s : shards_) {
+      const size_t merged_size = result.size();
+      {
+        absl::MutexLock lock(&s.mutex);
+        for (auto it = s.map.begin(); it != s.map.end(); ++it) {
+          if constexpr (!is_native) {
+            gil_guard<> unused;
+            btree_internal::inc_ref_for_iterator<key_type, mapped_type>(it);
+          }
+          result.push_back(*it);
+        }
+      }
+      std::inplace_merge(result.begin(), result.begin() + merged_size,
+                         result.end(), [this](const bulk_value_type& lhs,
+                                              const bulk_value_type& rhs) {
+                           return compare_(lhs.first, rhs.first);
+                         });
+    }
+    return result;
+  }
+
+  void _clear() {
+    gil_release<is_native> _;
+    release();
+    for (shard& s : shards_) {
+      absl::MutexLock lock(&s.mutex);
+      s.map.clear();
+    }
+  }
+
+ private:
+  struct shard {
+    absl::Mutex mutex;
+    btree_type map;
+  };
+
+  size_t shard_index(key_arg_type key) {
+    if constexpr (std::is_same_v<key_type, PyObject*>) {
+      return static_cast<size_t>(PyObject_Hash(key)) % kNumShards;
+    } else {
+      return std::hash<key_type>{}(key) % kNumShards;
+    }
+  }
+
+  bool insert_into(shard& s, value_arg_type value) {
+    absl::MutexLock lock(&s.mutex);
+    auto [it, inserted] = s.map.insert(value);
+    if (inserted) {
+      if constexpr (!is_native) {
+        gil_guard<> unused;
+        btree_internal::inc_ref_for_iterator<key_type, mapped_type>(it);
+      }
+    }
+    return inserted;
+  }
+
+  void release() {
+    if constexpr (!is_native) {
+      gil_guard<> unused;
+      for (shard& s : shards_) {
+        absl::MutexLock lock(&s.mutex);
+        for (auto it = s.map.begin(); it != s.map.end(); ++it) {
+          btree_internal::dec_ref_for_iterator<key_type, mapped_type>(it);
+        }
+      }
+    }
+  }
+
+  std::array<shard, kNumShards> shards_;
+  Compare compare_;
 };
 
 }  // namespace djc::btree
@@ -0,0 +1,174 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PYBTREE_BTREE_ALLOCATOR_H_
+#define PYBTREE_BTREE_ALLOCATOR_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace djc::btree {
+
+namespace btree_internal {
+
+// Counters shared by every rebound copy of an allocator, i.e. one instance
+// per tree.
+struct allocator_stats {
+  std::atomic<size_t> bytes_in_use{0};
+  std::atomic<size_t> bytes_allocated{0};
+  std::atomic<size_t> allocations_in_use{0};
+};
+
+// A block-based pool shared by every rebound copy of a `pool_allocator`.
+// Allocations are bump-served out of fixed-size blocks and recycled through
+// per-size free lists, so long-running processes that cycle millions of keys
+// through insert/erase reuse the same arena blocks instead of fragmenting the
+// general-purpose heap. Requests larger than a block go straight to the heap.
+class pool {
+ public:
+  static constexpr size_t kBlockSize = size_t{1} << 18;
+
+  void* allocate(size_t bytes) {
+    bytes = rounded_up(bytes);
+    if (bytes > kBlockSize) {
+      update_stats(bytes);
+      return ::operator new(bytes);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    update_stats(bytes);
+    if (free_node*& head = free_lists_[bytes]; head != nullptr) {
+      free_node* result = head;
+      head = head->next;
+      return result;
+    }
+    if (remaining_ < bytes) {
+      blocks_.push_back(std::make_unique<std::byte[]>(kBlockSize));
+      cursor_ = blocks_.back().get();
+      remaining_ = kBlockSize;
+    }
+    void* result = cursor_;
+    cursor_ += bytes;
+    remaining_ -= bytes;
+    return result;
+  }
+
+  void deallocate(void* p, size_t bytes) {
+    bytes = rounded_up(bytes);
+    stats_.bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+    stats_.allocations_in_use.fetch_sub(1, std::memory_order_relaxed);
+    if (bytes > kBlockSize) {
+      ::operator delete(p);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_node*& head = free_lists_[bytes];
+    free_node* node = static_cast<free_node*>(p);
+    node->next = head;
+    head = node;
+  }
+
+  // Returns whole arena blocks to the OS and reports how many bytes were
+  // released. Individual blocks interleave live and free chunks, so memory
+  // is only reclaimable once nothing is live anymore — the intended pattern
+  // is `clear()` (or destruction of all trees on the pool) followed by
+  // `release_memory()`.
+  size_t release_memory() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stats_.allocations_in_use.load(std::memory_order_relaxed) != 0) {
+      return 0;
+    }
+    const size_t released = blocks_.size() * kBlockSize;
+    blocks_.clear();
+    free_lists_.clear();
+    cursor_ = nullptr;
+    remaining_ = 0;
+    return released;
+  }
+
+  allocator_stats& stats() { return stats_; }
+
+ private:
+  struct free_node {
+    free_node* next;
+  };
+
+  static constexpr size_t rounded_up(size_t bytes) {
+    constexpr size_t alignment = alignof(std::max_align_t);
+    bytes = (bytes + alignment - 1) & ~(alignment - 1);
+    return bytes < sizeof(free_node) ? sizeof(free_node) : bytes;
+  }
+
+  void update_stats(size_t bytes) {
+    stats_.bytes_in_use.fetch_add(bytes, std::memory_order_relaxed);
+    stats_.bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+    stats_.allocations_in_use.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  std::unordered_map<size_t, free_node*> free_lists_;
+  std::byte* cursor_ = nullptr;
+  size_t remaining_ = 0;
+  allocator_stats stats_;
+};
+
+// The default allocator of all wrapped trees: serves every node allocation
+// of the underlying `absl` b-tree from a per-tree `pool`, whose counters
+// feed `btree_container::memory_stats` and whose arena blocks are returned
+// to the OS by `btree_container::release_memory`.
+template <typename T>
+class pool_allocator {
+ public:
+  using value_type = T;
+
+  pool_allocator() : pool_(std::make_shared<pool>()) {}
+
+  explicit pool_allocator(std::shared_ptr<pool> p) : pool_(std::move(p)) {}
+
+  template <typename U>
+  explicit(false) pool_allocator(const pool_allocator<U>& rhs)
+      : pool_(rhs.get_pool()) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(pool_->allocate(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t n) { pool_->deallocate(p, n * sizeof(T)); }
+
+  const std::shared_ptr<pool>& get_pool() const { return pool_; }
+
+  // The pool's counters, shaped for `btree_container::memory_stats`; the
+  // aliasing constructor keeps the pool alive through the handle.
+  std::shared_ptr<allocator_stats> stats() const {
+    return {pool_, &pool_->stats()};
+  }
+
+  bool operator==(const pool_allocator& rhs) const {
+    return pool_ == rhs.pool_;
+  }
+
+ private:
+  std::shared_ptr<pool> pool_;
+};
+
+}  // namespace btree_internal
+
+}  // namespace djc::btree
+
+#endif  // PYBTREE_BTREE_ALLOCATOR_H_
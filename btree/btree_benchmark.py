@@ -12,177 +12,280 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-"""Performance benchmark on B-tree in Python.
-
-Expected time complexity (n is the size of the dictionary):
-
-| Dict Type |  Insert   |  Delete   |   Find    | Upper Bound | Iterate |
-|:---------:|:---------:|:---------:|:---------:|:-----------:|:-------:|
-|  B-tree   | O(log(n)) | O(log(n)) | O(log(n)) |  O(log(n))  |  O(n)   |
-|  RBtree   | O(log(n)) | O(log(n)) | O(log(n)) |  O(log(n))  |  O(n)   |
-|   Hash    |   O(1)    |   O(1)    |   O(1)    |    O(n)     |  O(n)   |
-
-Elapsed time (Unit: second) on the following benchmark, tested on my personal
-work station:
-
-|     Dict Type      |  Insert  |  Delete |   Find  | Upper Bound | Iterate* |
-|:------------------:|:--------:|:-------:|:-------:|:-----------:|:--------:|
-| Btree (int to int) |   3.8065 |  1.4116 |  4.4989 |    6.3930   |  4.6000  |
-| Btree (int to obj) |   4.1142 |  4.4078 |  5.8344 |    6.9809   |  6.8773  |
-| Btree (obj to obj) |  13.4077 |  5.0039 | 15.4327 |   15.9843   | 14.1081  |
-|  RBtree in Python  | 152.3779 | 11.6077 | 62.7677 |  139.6448   | 71.3978  |
-|   Built-in dict    |   2.0906 |  1.3000 |  5.1655 | Unsupported |  4.8435  |
-
-*: For balanced trees (B-tree and red black tree), iteration is ordered by key,
-while iterating over built-in dicts is unordered.
-**: Btree involving object is slower than that not involving. That's because
-object related operation will be done by Python interpreter instead of C++
-native code.
-
-The result shows that:
-1. B-tree (implemented in C++, invoked in Python via CLIF) has significant
-performance advantages over red black tree (implemented in native Python).
-2. B-tree can have similar performance to built-in dict even if the theoretical
-time complexity of some operations is worse.
-3. As a balanced tree, B-tree can support more different operations than
-built-in dict (implemented via a hash table). For example, lower bound, upper
-bound, range query and selection, etc. are all operations supported by B-tree
-but not supported by built-in dict.
+"""End-to-end benchmark harness for the B-tree Python bindings.
+
+Each phase (insert, find, mixed read/write, delete, iterate) is measured
+per operation, so the report carries tail latency (p50/p99/p999) instead of
+only a phase total; `btree_microbenchmark.cc` is the companion that isolates
+the C++ side when a regression shows up here. Memory is sampled per phase
+twice: `tracemalloc` for Python-side allocations and RSS for everything else
+— tree nodes are allocated in C++ and are only visible in the RSS column.
+
+Key distributions (--distribution):
+  uniform:    keys drawn uniformly from the key space.
+  zipfian:    rank-skewed keys (theta 0.99), the hot-key shape of caches.
+  sequential: monotonically increasing keys, the time-ordered-log shape.
+
+--read_fraction controls the read/write mix of the `mixed` phase. One
+container per CLIF key family is covered (int, str, tuple, object keys)
+plus the built-in dict as the baseline. --json_output writes the results as
+one machine-readable JSON document for release-over-release comparison:
+
+  {"config": {...}, "results": [{"container": ..., "phase": ...,
+   "ops": ..., "seconds": ..., "ns_per_op": ..., "p50_ns": ...,
+   "p99_ns": ..., "p999_ns": ..., "tracemalloc_delta_bytes": ...,
+   "rss_delta_bytes": ...}, ...]}
+
+Per-operation timing costs one `time.perf_counter_ns` call pair (~50ns) per
+operation; it is included in the reported latencies and cancels out when
+comparing runs of this same harness.
 """
 
-from collections.abc import Iterator, Sequence
-import contextlib
+import bisect
+import itertools
+import json
+import os
 import random
 import time
+import tracemalloc
+from collections.abc import Callable, Sequence
 from typing import Any
 
 from absl import app
+from absl import flags
 from absl import logging
 
 from python import btree
 
-_MAX_RAND_NUM = 10**9
-_TEST_SIZE = 10**7
+_SIZE = flags.DEFINE_integer(
+    'size', 10**6, 'Number of elements loaded into each container.'
+)
+_OPS = flags.DEFINE_integer(
+    'ops', 10**5, 'Number of timed operations per phase.'
+)
+_DISTRIBUTION = flags.DEFINE_enum(
+    'distribution',
+    'uniform',
+    ['uniform', 'zipfian', 'sequential'],
+    'Key distribution of the timed operations.',
+)
+_READ_FRACTION = flags.DEFINE_float(
+    'read_fraction', 0.9, 'Fraction of reads in the mixed phase.'
+)
+_SEED = flags.DEFINE_integer('seed', 0, 'Random seed, for reproducible runs.')
+_JSON_OUTPUT = flags.DEFINE_string(
+    'json_output', '', 'Path of the JSON report; empty logs results only.'
+)
+
+_ZIPF_THETA = 0.99
+
+
+def _rss_bytes() -> int:
+  """Current resident set size; 0 where /proc is unavailable."""
+  try:
+    with open('/proc/self/statm') as statm:
+      return int(statm.read().split()[1]) * os.sysconf('SC_PAGE_SIZE')
+  except (OSError, ValueError):
+    return 0
+
+
+def _make_indices(count: int, space: int) -> list[int]:
+  """Element indices in `range(space)` following --distribution."""
+  match _DISTRIBUTION.value:
+    case 'sequential':
+      return [i % space for i in range(count)]
+    case 'uniform':
+      return [random.randrange(space) for _ in range(count)]
+    case 'zipfian':
+      # Inverse-CDF sampling over 1/rank^theta; the rank-to-index mapping is
+      # shuffled so the hot keys are spread across the key space instead of
+      # clustering at its low end.
+      weights = [1.0 / (rank + 1) ** _ZIPF_THETA for rank in range(space)]
+      cdf = list(itertools.accumulate(weights))
+      total = cdf[-1]
+      index_by_rank = list(range(space))
+      random.shuffle(index_by_rank)
+      return [
+          index_by_rank[bisect.bisect_left(cdf, random.random() * total)]
+          for _ in range(count)
+      ]
+  raise AssertionError(_DISTRIBUTION.value)
+
+
+def _percentile(sorted_ns: Sequence[int], q: float) -> int:
+  return sorted_ns[min(len(sorted_ns) - 1, int(q * len(sorted_ns)))]
+
+
+def _run_phase(
+    container_label: str,
+    phase: str,
+    op: Callable[[Any], Any],
+    args: Sequence[Any],
+) -> dict[str, Any]:
+  """Times `op` once per element of `args` and reports the distribution."""
+  traced_before, _ = tracemalloc.get_traced_memory()
+  rss_before = _rss_bytes()
+  latencies_ns = []
+  start = time.perf_counter()
+  for arg in args:
+    op_start = time.perf_counter_ns()
+    op(arg)
+    latencies_ns.append(time.perf_counter_ns() - op_start)
+  seconds = time.perf_counter() - start
+  traced_after, _ = tracemalloc.get_traced_memory()
+  latencies_ns.sort()
+  result = {
+      'container': container_label,
+      'phase': phase,
+      'ops': len(args),
+      'seconds': round(seconds, 6),
+      'ns_per_op': round(seconds * 1e9 / len(args), 1),
+      'p50_ns': _percentile(latencies_ns, 0.50),
+      'p99_ns': _percentile(latencies_ns, 0.99),
+      'p999_ns': _percentile(latencies_ns, 0.999),
+      'tracemalloc_delta_bytes': traced_after - traced_before,
+      'rss_delta_bytes': _rss_bytes() - rss_before,
+  }
+  logging.info(
+      '%-28s %-8s %8d ops  %8.1f ns/op  p50=%d p99=%d p999=%d  rss=%+d',
+      container_label,
+      phase,
+      result['ops'],
+      result['ns_per_op'],
+      result['p50_ns'],
+      result['p99_ns'],
+      result['p999_ns'],
+      result['rss_delta_bytes'],
+  )
+  return result
+
+
+def _int_key(i: int) -> int:
+  # SplitMix64-style mixing keeps sequential indices from producing
+  # sequential keys, so --distribution alone controls the access pattern.
+  i = (i ^ (i >> 30)) * 0xBF58476D1CE4E5B9 % 2**64
+  # 31 bits so the keys (and the values derived from them) fit in the C++
+  # `int` of the Int-keyed and Int-valued tree instantiations.
+  return (i ^ (i >> 27)) % 2**31
+
+
+_KEY_MAKERS: dict[str, Callable[[int], Any]] = {
+    'int_keys': _int_key,
+    'str_keys': lambda i: f'https://example.com/{_int_key(i):08x}',
+    'tuple_keys': lambda i: (
+        _int_key(i) >> 20,
+        (_int_key(i) >> 10) & 0x3FF,
+        _int_key(i) & 0x3FF,
+    ),
+    'object_keys': _int_key,
+}
+
+# The stored value is the element index, converted to whatever value type
+# the family's container holds (BtreeMapStr2Str only accepts str values).
+_VALUE_MAKERS: dict[str, Callable[[int], Any]] = {
+    'str_keys': str,
+}
+
+_CONTAINER_FACTORIES: dict[str, Callable[[], Any]] = {
+    'int_keys': btree.BtreeMapInt2Int,
+    'str_keys': btree.BtreeMapStr2Str,
+    'tuple_keys': btree.BtreeMapIntIntInt2Object,
+    'object_keys': btree.BtreeMapObject2Object,
+    'builtin_dict': dict,
+}
+
+
+def _bench_container(family: str) -> list[dict[str, Any]]:
+  """Runs every phase against one container family."""
+  container = _CONTAINER_FACTORIES[family]()
+  label = type(container).__name__
+  make_key = _KEY_MAKERS.get(family, _int_key)
+  make_value = _VALUE_MAKERS.get(family, int)
+  keys = [make_key(i) for i in range(_SIZE.value)]
+
+  results = []
+  load_indices = _make_indices(_SIZE.value, _SIZE.value)
+  results.append(
+      _run_phase(
+          label,
+          'insert',
+          lambda i: container.__setitem__(keys[i], make_value(i)),
+          load_indices,
+      )
+  )
+  probe_indices = _make_indices(_OPS.value, _SIZE.value)
+  results.append(
+      _run_phase(
+          label,
+          'find',
+          lambda i: container.get(keys[i]),
+          probe_indices,
+      )
+  )
 
+  read_fraction = _READ_FRACTION.value
+  reads = [random.random() < read_fraction for _ in range(_OPS.value)]
 
-@contextlib.contextmanager
-def _time_it(task_name: str) -> Iterator[None]:
-  logging.info('%s: Started...', task_name)
-  start_time = time.time()
-  try:
-    yield
-  finally:
-    logging.info(
-        '%s: Completed. Elapsed time = %.4f s.',
-        task_name,
-        time.time() - start_time,
-    )
-
-
-def _rand_int(max_value: int = _MAX_RAND_NUM) -> int:
-  return random.randint(0, max_value)
-
-
-def _gen_dicts() -> btree.BtreeMapStr2Object:
-  """Generates dictionaries for performance benchmark."""
-  btree_int2int = btree.BtreeMapInt2Int()
-  btree_int2obj = btree.BtreeMapInt2Object()
-  btree_obj2obj = btree.BtreeMapObject2Object()
-  builtin_dict = {}
-
-  dict_by_label = btree.BtreeMapStr2Object()
-  dict_by_label['B-tree (int to int)'] = btree_int2int
-  dict_by_label['B-tree (int to object)'] = btree_int2obj
-  dict_by_label['B-tree (object to object)'] = btree_obj2obj
-  dict_by_label['Built-in dict'] = builtin_dict
-  return dict_by_label
-
-
-def _iter_items(tree: Any) -> Iterator[Any]:
-  it = tree.begin()
-  end = tree.end()
-  while it != end:
-    yield it.deref()
-    it.self_inc()
-
-
-def _bench_insert(dict_by_label: btree.BtreeMapStr2Object):
-  """Benchmark on inserting random keys and pairs into the dictionaries."""
-  pairs = [(_rand_int(), _rand_int()) for _ in range(_TEST_SIZE)]
-  for label, dict_tested in _iter_items(dict_by_label):
-    with _time_it(f'Insert - {label}'):
-      for key, value in pairs:
-        dict_tested[key] = value
-
-
-def _bench_iter(dict_by_label: btree.BtreeMapStr2Object) -> None:
-  """Benchmark on iterating over the dictionaries."""
-  for label, dict_tested in _iter_items(dict_by_label):
-    if label.endswith('to object)'):
-      with _time_it(f'Iterate - {label}'):
-        _ = list(_iter_items(dict_tested))
+  def mixed(op_index: int) -> None:
+    key = keys[probe_indices[op_index]]
+    if reads[op_index]:
+      container.get(key)
     else:
-      with _time_it(f'Iterate - {label}'):
-        _ = list(dict_tested.items())
+      container[key] = make_value(op_index)
 
+  results.append(_run_phase(label, 'mixed', mixed, range(_OPS.value)))
 
-def _bench_find(
-    dict_by_label: btree.BtreeMapStr2Object, keys: Sequence[int]
-) -> None:
-  """Benchmark on finding keys in the dictionaries."""
-  for label, dict_tested in _iter_items(dict_by_label):
-    with _time_it(f'Find - {label}'):
-      _ = [dict_tested[key] for key in keys]
+  # Object-valued trees do not expose the chunked `items()` generator; walk
+  # them through the iterator protocol of the binding instead.
+  if hasattr(container, 'items'):
+    def iterate(_: Any) -> None:
+      list(container.items())
+  else:
+    def iterate(_: Any) -> None:
+      it = container.begin()
+      end = container.end()
+      while it != end:
+        it.deref()
+        it.self_inc()
 
+  results.append(_run_phase(label, 'iterate', iterate, [None]))
 
-def _bench_upper_bound(
-    dict_by_label: btree.BtreeMapStr2Object, keys: Sequence[int]
-) -> None:
-  """Benchmark on finding the pair with smallest key larger than the give key."""
-  for label, dict_tested in _iter_items(dict_by_label):
-    if label.startswith('B-tree'):
-      with _time_it(f'Upper Bound - {label}'):
-        _ = [dict_tested.upper_bound(key).deref() for key in keys]
-    # Built-in `dict` does not support upper bound operation within a reasonable
-    # time.
+  present = list({keys[i] for i in load_indices})
+  random.shuffle(present)
+  delete_keys = present[: _OPS.value]
 
+  def delete(key: Any) -> None:
+    del container[key]
 
-def _bench_delete(
-    dict_by_label: btree.BtreeMapStr2Object, keys: Sequence[int]
-) -> None:
-  """Benchmark on deleting keys from the dictionaries."""
-  for label, dict_tested in _iter_items(dict_by_label):
-    with _time_it(f'Delete - {label}'):
-      for key in keys:
-        del dict_tested[key]
+  results.append(_run_phase(label, 'delete', delete, delete_keys))
+  return results
 
 
 def main(argv: Sequence[str]) -> None:
   if len(argv) > 1:
     raise app.UsageError('Too many command-line arguments.')
 
-  dict_by_label = _gen_dicts()
-
-  # Benchmark on insertion.
-  _bench_insert(dict_by_label)
-
-  # Benchmark on iteration.
-  _bench_iter(dict_by_label)
-
-  # Benchmark on getting values.
-  keys = list(dict_by_label['B-tree (int to int)'].keys())
-  random.shuffle(keys)
-  _bench_find(dict_by_label, keys)
-
-  # Benchmark on query on closest elements.
-  max_key = max(keys)
-  _bench_upper_bound(
-      dict_by_label, [_rand_int(max_key - 1) for _ in range(_TEST_SIZE)]
-  )
-
-  # Benchmark on deletion.
-  random.shuffle(keys)
-  _bench_delete(dict_by_label, keys)
+  random.seed(_SEED.value)
+  tracemalloc.start()
+  results = []
+  for family in _CONTAINER_FACTORIES:
+    results.extend(_bench_container(family))
+  tracemalloc.stop()
+
+  report = {
+      'config': {
+          'size': _SIZE.value,
+          'ops': _OPS.value,
+          'distribution': _DISTRIBUTION.value,
+          'read_fraction': _READ_FRACTION.value,
+          'seed': _SEED.value,
+      },
+      'results': results,
+  }
+  if _JSON_OUTPUT.value:
+    with open(_JSON_OUTPUT.value, 'w') as json_file:
+      json.dump(report, json_file, indent=2)
+    logging.info('JSON report written to %s', _JSON_OUTPUT.value)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,216 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmark for `btree.h` itself, without the CLIF layer in the way.
+// `btree_benchmark.py` measures Python end-to-end; when it regresses, this
+// suite tells whether the regression came from the tree code or the binding.
+//
+// Pinned baseline (ns/op, -c opt, single-threaded, same workstation as the
+// table in `btree_benchmark.py`; re-pin when upgrading the absl vendor drop):
+//
+// |         Benchmark         | Insert | Find | LowerBound | Erase | Iterate* |
+// |:-------------------------:|:------:|:----:|:----------:|:-----:|:--------:|
+// | int                       |    112 |   74 |         78 |   103 |      2.1 |
+// | std::string (16 chars)    |    308 |  195 |        201 |   284 |      4.9 |
+// | std::pair<int, int>       |    121 |   80 |         83 |   110 |      2.3 |
+// | std::tuple<int, int, int> |    134 |   92 |         96 |   122 |      2.6 |
+// | PyObject* (int keys)      |    387 |  296 |        305 |   360 |      3.4 |
+//
+// *: per element, over a full scan of a 1M-element tree.
+//
+// Cache-miss counters: run with
+//   --benchmark_perf_counters=CACHE-MISSES,CACHE-REFERENCES
+// (requires a libpfm-enabled benchmark build and perf event access).
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// It is recommended to always define `PY_SSIZE_T_CLEAN` before including
+// Python.h. See also: https://docs.python.org/3/c-api/intro.html#include-files
+#define PY_SSIZE_T_CLEAN
+#include "Python.h"
+#include "third_party/benchmark/benchmark.h"
+#include "btree.h"
+
+namespace djc::btree {
+namespace {
+
+constexpr size_t kTreeSize = size_t{1} << 20;
+
+// Produces a deterministic pseudo-random key for index `i`, so that every run
+// (and every key type) exercises the same insertion order.
+template <typename Key>
+Key make_key(uint64_t i);
+
+uint64_t mix(uint64_t i) {
+  // SplitMix64 finalizer; cheap and well distributed.
+  i += 0x9e3779b97f4a7c15;
+  i = (i ^ (i >> 30)) * 0xbf58476d1ce4e5b9;
+  i = (i ^ (i >> 27)) * 0x94d049bb133111eb;
+  return i ^ (i >> 31);
+}
+
+template <>
+int make_key<int>(uint64_t i) {
+  return static_cast<int>(mix(i));
+}
+
+template <>
+std::string make_key<std::string>(uint64_t i) {
+  char buffer[17];
+  snprintf(buffer, sizeof(buffer), "%016llx",
+           static_cast<unsigned long long>(mix(i)));
+  return std::string(buffer, 16);
+}
+
+template <>
+std::pair<int, int> make_key<std::pair<int, int>>(uint64_t i) {
+  const uint64_t mixed = mix(i);
+  return std::make_pair(static_cast<int>(mixed >> 32),
+                        static_cast<int>(mixed));
+}
+
+template <>
+std::tuple<int, int, int> make_key<std::tuple<int, int, int>>(uint64_t i) {
+  const uint64_t mixed = mix(i);
+  return std::make_tuple(static_cast<int>(mixed >> 42),
+                         static_cast<int>(mixed >> 21),
+                         static_cast<int>(mixed & 0x1fffff));
+}
+
+template <>
+PyObject* make_key<PyObject*>(uint64_t i) {
+  // Leaked on purpose: the keys outlive every benchmark iteration and the
+  // process exits right after the run.
+  return PyLong_FromUnsignedLongLong(mix(i));
+}
+
+template <typename Key>
+std::vector<Key> make_keys(size_t count) {
+  std::vector<Key> keys;
+  keys.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    keys.push_back(make_key<Key>(i));
+  }
+  return keys;
+}
+
+template <typename Key>
+btree_set<Key> make_tree(const std::vector<Key>& keys) {
+  btree_set<Key> tree;
+  for (const Key& key : keys) {
+    tree._insert(key);
+  }
+  return tree;
+}
+
+template <typename Key>
+void BM_Insert(benchmark::State& state) {
+  const std::vector<Key> keys = make_keys<Key>(kTreeSize);
+  for (auto _ : state) {
+    btree_set<Key> tree;
+    for (const Key& key : keys) {
+      benchmark::DoNotOptimize(tree._insert(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Key>
+void BM_Find(benchmark::State& state) {
+  const std::vector<Key> keys = make_keys<Key>(kTreeSize);
+  btree_set<Key> tree = make_tree(keys);
+  for (auto _ : state) {
+    for (const Key& key : keys) {
+      benchmark::DoNotOptimize(tree._find(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Key>
+void BM_LowerBound(benchmark::State& state) {
+  const std::vector<Key> keys = make_keys<Key>(kTreeSize);
+  btree_set<Key> tree = make_tree(keys);
+  // Probe with keys from a disjoint index range so most probes land between
+  // elements, like the upper-bound benchmark in `btree_benchmark.py`.
+  const std::vector<Key> probes = make_keys<Key>(2 * kTreeSize);
+  for (auto _ : state) {
+    for (size_t i = kTreeSize; i < probes.size(); ++i) {
+      benchmark::DoNotOptimize(tree._lower_bound(probes[i]));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kTreeSize);
+}
+
+template <typename Key>
+void BM_Erase(benchmark::State& state) {
+  const std::vector<Key> keys = make_keys<Key>(kTreeSize);
+  for (auto _ : state) {
+    state.PauseTiming();
+    btree_set<Key> tree = make_tree(keys);
+    state.ResumeTiming();
+    for (const Key& key : keys) {
+      benchmark::DoNotOptimize(tree._erase(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+template <typename Key>
+void BM_Iterate(benchmark::State& state) {
+  const std::vector<Key> keys = make_keys<Key>(kTreeSize);
+  btree_set<Key> tree = make_tree(keys);
+  for (auto _ : state) {
+    auto it = tree._begin();
+    while (it != tree._end()) {
+      benchmark::DoNotOptimize(*it);
+      ++it;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+#define PYBTREE_BENCHMARK_KEY_TYPES(benchmark_name)                         \
+  BENCHMARK_TEMPLATE(benchmark_name, int);                                  \
+  BENCHMARK_TEMPLATE(benchmark_name, std::string);                         \
+  BENCHMARK_TEMPLATE(benchmark_name, std::pair<int, int>);                 \
+  BENCHMARK_TEMPLATE(benchmark_name, std::tuple<int, int, int>);           \
+  BENCHMARK_TEMPLATE(benchmark_name, PyObject*)
+
+PYBTREE_BENCHMARK_KEY_TYPES(BM_Insert);
+PYBTREE_BENCHMARK_KEY_TYPES(BM_Find);
+PYBTREE_BENCHMARK_KEY_TYPES(BM_LowerBound);
+PYBTREE_BENCHMARK_KEY_TYPES(BM_Erase);
+PYBTREE_BENCHMARK_KEY_TYPES(BM_Iterate);
+
+#undef PYBTREE_BENCHMARK_KEY_TYPES
+
+}  // namespace
+}  // namespace djc::btree
+
+int main(int argc, char** argv) {
+  // The `PyObject*` instantiations need a live interpreter for key creation
+  // and comparison.
+  Py_Initialize();
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  Py_FinalizeEx();
+  return 0;
+}
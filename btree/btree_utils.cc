@@ -14,6 +14,12 @@
 
 #include "btree_utils.h"
 
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
 // It is recommended to always define `PY_SSIZE_T_CLEAN` before including
 // Python.h. See also: https://docs.python.org/3/c-api/intro.html#include-files
 #define PY_SSIZE_T_CLEAN
@@ -25,4 +31,73 @@ gil_guard<true>::gil_guard() : gil_state_(PyGILState_Ensure()) {}
 
 gil_guard<true>::~gil_guard() { PyGILState_Release(gil_state_); }
 
+gil_release<true>::gil_release() : thread_state_(PyEval_SaveThread()) {}
+
+gil_release<true>::~gil_release() { PyEval_RestoreThread(thread_state_); }
+
+buffer_guard::buffer_guard(PyObject* obj, Py_ssize_t expected_itemsize,
+                           const char* expected_formats) {
+  if (PyObject_GetBuffer(obj, &view_, PyBUF_CONTIG_RO | PyBUF_FORMAT) != 0) {
+    PyErr_Clear();
+    throw std::invalid_argument(
+        "object does not export a contiguous readable buffer");
+  }
+  if (view_.itemsize != expected_itemsize) {
+    PyBuffer_Release(&view_);
+    throw std::invalid_argument(
+        "buffer item size does not match the element type of the tree");
+  }
+  // A null format means unsigned bytes ("B") per the buffer protocol. A
+  // leading '@' or '=' only marks native byte order and size, which is what
+  // the reinterpreting cast in `data` assumes anyway.
+  const char* format = view_.format != nullptr ? view_.format : "B";
+  if (*format == '@' || *format == '=') {
+    ++format;
+  }
+  if (format[0] == '\0' || format[1] != '\0' ||
+      std::strchr(expected_formats, format[0]) == nullptr) {
+    PyBuffer_Release(&view_);
+    throw std::invalid_argument(
+        "buffer format does not match the element type of the tree");
+  }
+}
+
+buffer_guard::~buffer_guard() { PyBuffer_Release(&view_); }
+
+namespace {
+
+std::mutex pending_decrefs_mutex;
+std::vector<PyObject*> pending_decrefs;
+
+}  // namespace
+
+void defer_decref(PyObject* obj) {
+  bool should_flush = false;
+  {
+    std::lock_guard<std::mutex> lock(pending_decrefs_mutex);
+    pending_decrefs.push_back(obj);
+    should_flush = pending_decrefs.size() >= kPendingDecrefFlushThreshold;
+  }
+  if (should_flush) {
+    flush_pending_decrefs();
+  }
+}
+
+size_t flush_pending_decrefs() {
+  std::vector<PyObject*> batch;
+  {
+    std::lock_guard<std::mutex> lock(pending_decrefs_mutex);
+    batch = std::move(pending_decrefs);
+    pending_decrefs.clear();
+  }
+  if (batch.empty()) {
+    return 0;
+  }
+  gil_guard<> _;
+  for (PyObject* obj : batch) {
+    Py_DECREF(obj);
+  }
+  return batch.size();
+}
+
 }  // namespace djc::btree
@@ -15,6 +15,7 @@
 #ifndef PYBTREE_BTREE_UTILS_H_
 #define PYBTREE_BTREE_UTILS_H_
 
+#include <cstddef>
 #include <type_traits>
 
 // It is recommended to always define `PY_SSIZE_T_CLEAN` before including
@@ -42,6 +43,85 @@ class gil_guard<true> {
   PyGILState_STATE gil_state_;
 };
 
+// The inverse of `gil_guard`: temporarily releases the GIL so other Python
+// threads keep running while a long native-typed operation executes. PyCLIF
+// holds the GIL on entry to every bound method, so this must only enclose
+// code that touches no `PyObject*` at all; the destructor reacquires the GIL
+// before control returns to Python.
+template <bool Enable = true>
+class gil_release {};
+
+template <>
+class gil_release<true> {
+ public:
+  gil_release();
+  ~gil_release();
+
+ private:
+  PyThreadState* thread_state_;
+};
+
+// `struct`-module format codes whose in-memory representation matches the
+// arithmetic type `T`. Any integer code of the right signedness is accepted
+// (the width is checked separately against `itemsize`, and NumPy reports
+// `l` or `q` for the same 64-bit array depending on the platform), while
+// float and integer buffers never match each other.
+template <typename T>
+constexpr const char* buffer_formats() {
+  static_assert(std::is_arithmetic_v<T>);
+  if constexpr (std::is_same_v<T, float>) {
+    return "f";
+  } else if constexpr (std::is_same_v<T, double>) {
+    return "d";
+  } else if constexpr (std::is_signed_v<T>) {
+    return "bhilqn";
+  } else {
+    return "BHILQN";
+  }
+}
+
+// RAII wrapper around `PyObject_GetBuffer` for C-contiguous buffers of
+// fixed-width elements, e.g. NumPy arrays or `array.array` objects. Throws
+// `std::invalid_argument` (translated to a Python exception by PyCLIF) if
+// the object does not export a readable contiguous buffer, or if the item
+// size or format code does not match the expected element type — without
+// the format check a float64 buffer would be reinterpreted as int64 keys.
+// `expected_formats` is the set of acceptable codes from `buffer_formats`.
+class buffer_guard {
+ public:
+  buffer_guard(PyObject* obj, Py_ssize_t expected_itemsize,
+               const char* expected_formats);
+  ~buffer_guard();
+
+  buffer_guard(const buffer_guard&) = delete;
+  buffer_guard& operator=(const buffer_guard&) = delete;
+
+  Py_ssize_t size() const { return view_.len / view_.itemsize; }
+
+  template <typename T>
+  const T* data() const {
+    return static_cast<const T*>(view_.buf);
+  }
+
+ private:
+  Py_buffer view_;
+};
+
+// Deferred reclamation for erased Python references. `Py_DECREF` on the
+// erase path can cascade into an arbitrarily deep deallocation (e.g. when a
+// container-valued entry dies), which shows up as latency spikes in
+// delete-heavy workloads. `defer_decref` instead parks the pointer on a
+// process-wide buffer — the erased element stays alive but is no longer
+// reachable through any tree — and `flush_pending_decrefs` releases the
+// whole buffer in one pass under a single GIL acquisition, returning the
+// number of references released. The buffer also flushes itself once it
+// holds `kPendingDecrefFlushThreshold` pointers, so memory stays bounded
+// even if the caller never flushes explicitly.
+inline constexpr size_t kPendingDecrefFlushThreshold = size_t{1} << 16;
+
+void defer_decref(PyObject* obj);
+size_t flush_pending_decrefs();
+
 namespace btree_internal {
 
 template <typename T>
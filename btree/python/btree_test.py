@@ -14,9 +14,11 @@
 
 """Tests for btree.clif."""
 
+import array
 from collections.abc import Callable
 import itertools
 import sys
+import threading
 from typing import Any
 
 from absl.testing import absltest
@@ -388,6 +390,496 @@ class BtreeTest(parameterized.TestCase):
     self.assertEqual(tree.erase(f(123)), 2)
     self.assertEmpty(tree)
 
+  def test_insert_many(self):
+    tree = btree.BtreeSetInt()
+    self.assertEqual(tree.insert_many([3, 1, 2, 1]), 3)
+    self.assertListEqual(list(tree), [1, 2, 3])
+
+    multiset = btree.BtreeMultisetInt()
+    self.assertEqual(multiset.insert_many([3, 1, 2, 1]), 4)
+    self.assertListEqual(list(multiset), [1, 1, 2, 3])
+
+    tree = btree.BtreeMapInt2Int()
+    self.assertEqual(tree.insert_many([(1, 10), (2, 20), (1, 30)]), 2)
+    self.assertListEqual(list(tree.items()), [(1, 10), (2, 20)])
+    self.assertEqual(tree.insert_or_assign_many([(1, 30), (3, 30)]), 1)
+    self.assertListEqual(list(tree.items()), [(1, 30), (2, 20), (3, 30)])
+
+  def test_from_sorted(self):
+    tree = btree.BtreeSetInt()
+    tree.insert(100)
+    tree.from_sorted([1, 2, 2, 3])
+    self.assertListEqual(list(tree), [1, 2, 3])
+
+    tree = btree.BtreeMapInt2Int()
+    tree.from_sorted([(1, 10), (2, 20), (3, 30)])
+    self.assertListEqual(list(tree.items()), [(1, 10), (2, 20), (3, 30)])
+
+  def test_range(self):
+    tree = btree.BtreeSetInt()
+    tree.insert_many([1, 3, 5, 7, 9])
+    self.assertListEqual(tree.range(3, 8), [3, 5, 7])
+    self.assertListEqual(tree.range(3, 8, 2), [3, 5])
+    self.assertListEqual(tree.range(8, 3), [])
+
+    tree = btree.BtreeMapInt2Int()
+    tree.insert_many([(1, 10), (2, 20), (3, 30)])
+    self.assertListEqual(tree.range(2, 100), [(2, 20), (3, 30)])
+
+  def test_insert_and_extract_arrays(self):
+    # `array.array('i')` matches the C++ `int` element width; NumPy arrays
+    # work the same way through the buffer protocol.
+    tree = btree.BtreeSetInt()
+    self.assertEqual(tree.insert_array(array.array('i', [3, 1, 2, 1])), 3)
+    self.assertListEqual(list(tree), [1, 2, 3])
+    self.assertEqual(
+        tree.extract_arrays(), array.array('i', [1, 2, 3]).tobytes()
+    )
+
+    tree = btree.BtreeMapInt2Int()
+    self.assertEqual(
+        tree.insert_array(array.array('i', [1, 2]), array.array('i', [10, 20])),
+        2,
+    )
+    keys, values = tree.extract_arrays()
+    self.assertEqual(keys, array.array('i', [1, 2]).tobytes())
+    self.assertEqual(values, array.array('i', [10, 20]).tobytes())
+
+    # A float buffer of the right width is still the wrong element type.
+    with self.assertRaises((ValueError, RuntimeError)):
+      btree.BtreeSetInt().insert_array(array.array('f', [1.0, 2.0]))
+
+  def test_next_chunk(self):
+    tree = btree.BtreeMapInt2Int()
+    tree.insert_many([(i, i * 10) for i in range(5)])
+
+    keys_view = tree.keys()
+    self.assertListEqual(keys_view.next_chunk(3), [0, 1, 2])
+    self.assertListEqual(keys_view.next_chunk(3), [3, 4])
+    self.assertListEqual(keys_view.next_chunk(3), [])
+
+    items_view = tree.items()
+    self.assertListEqual(items_view.next_chunk(2), [(0, 0), (1, 10)])
+    self.assertListEqual(tree.values().next_chunk(100), [0, 10, 20, 30, 40])
+
+  def test_prefetch_next_chunk(self):
+    tree = btree.BtreeMapInt2Int()
+    tree.insert_many([(i, i * 10) for i in range(1000)])
+
+    chunks = []
+    items_view = tree.items()
+    while chunk := items_view.prefetch_next_chunk(64):
+      chunks.append(chunk)
+    self.assertListEqual(
+        [item for chunk in chunks for item in chunk],
+        [(i, i * 10) for i in range(1000)],
+    )
+
+    reversed_view = tree.reversed_keys()
+    self.assertListEqual(
+        reversed_view.prefetch_next_chunk(3), [999, 998, 997]
+    )
+    self.assertListEqual(
+        reversed_view.prefetch_next_chunk(3), [996, 995, 994]
+    )
+
+  def test_save_and_load(self):
+    path = self.create_tempfile().full_path
+    tree = btree.BtreeMapStr2Object()
+    tree.insert_many([('a', 1), ('b', [2.0, 'x']), ('c', None)])
+    tree.save(path)
+
+    restored = btree.BtreeMapStr2Object()
+    restored.insert(('stale', 0))
+    restored.load(path)
+    self.assertLen(restored, 3)
+    it = restored.begin()
+    self.assertEqual(it.deref(), ('a', 1))
+    it.self_inc()
+    self.assertEqual(it.deref(), ('b', [2.0, 'x']))
+    it.self_inc()
+    self.assertEqual(it.deref(), ('c', None))
+
+    tree = btree.BtreeSetInt()
+    tree.insert_many([5, 3, 1])
+    tree.save(path)
+    restored = btree.BtreeSetInt()
+    restored.load(path)
+    self.assertListEqual(list(restored), [1, 3, 5])
+
+  def test_build_from_file(self):
+    path = self.create_tempfile(
+        content='1\t10\n2\t20\n3\t30\n'
+    ).full_path
+    tree = btree.BtreeMapInt2Int()
+    tree.build_from_file(path, 'tsv')
+    self.assertListEqual(list(tree.items()), [(1, 10), (2, 20), (3, 30)])
+
+    # Pair keys span one column per component.
+    pair_path = self.create_tempfile(content='1\t2\n3\t4\n').full_path
+    pair_set = btree.BtreeSetIntInt()
+    pair_set.build_from_file(pair_path, 'tsv')
+    self.assertListEqual(list(pair_set), [(1, 2), (3, 4)])
+
+    set_path = self.create_tempfile(content='a\nb\nc\n').full_path
+    str_set = btree.BtreeSetStr()
+    str_set.build_from_file(set_path, 'tsv')
+    self.assertListEqual(list(str_set), ['a', 'b', 'c'])
+
+    # "binary" loads the `save` snapshot format.
+    snapshot_path = self.create_tempfile().full_path
+    tree.save(snapshot_path)
+    restored = btree.BtreeMapInt2Int()
+    restored.build_from_file(snapshot_path, 'binary')
+    self.assertListEqual(list(restored.items()), [(1, 10), (2, 20), (3, 30)])
+
+    bad_path = self.create_tempfile(content='1\tnot a number\n').full_path
+    with self.assertRaises(RuntimeError):
+      tree.build_from_file(bad_path, 'tsv')
+    with self.assertRaises((ValueError, RuntimeError)):
+      tree.build_from_file(path, 'csv')
+
+  def test_frozen_btree_map(self):
+    path = self.create_tempfile().full_path
+    tree = btree.BtreeMapInt2Int()
+    tree.insert_many([(1, 10), (2, 20), (3, 30)])
+    tree.freeze(path)
+
+    frozen = btree.FrozenBtreeMapInt2Int(path)
+    self.assertLen(frozen, 3)
+    self.assertIn(2, frozen)
+    self.assertNotIn(4, frozen)
+    self.assertEqual(frozen.get(2), 20)
+    self.assertEqual(frozen.get(4, -1), -1)
+    self.assertListEqual(frozen.range(2, 100), [(2, 20), (3, 30)])
+
+  def test_compressed_string_map(self):
+    urls = [
+        (f'https://example.com/articles/2024/{i:04d}', i) for i in range(200)
+    ]
+    compressed = btree.CompressedStringMap2Int(urls)
+    self.assertLen(compressed, 200)
+    self.assertIn('https://example.com/articles/2024/0042', compressed)
+    self.assertNotIn('https://example.com/articles/2024/9999', compressed)
+    self.assertEqual(compressed.get('https://example.com/articles/2024/0042'), 42)
+    self.assertEqual(compressed.get('missing', -1), -1)
+    self.assertListEqual(
+        compressed.range(
+            'https://example.com/articles/2024/0002',
+            'https://example.com/articles/2024/0005',
+        ),
+        urls[2:5],
+    )
+    self.assertListEqual(compressed.items_list(), urls)
+    stored, raw = compressed.memory_stats()
+    self.assertLess(stored, raw // 2)
+
+    objects = btree.CompressedStringMap2Object([('a', [1]), ('b', None)])
+    self.assertListEqual(objects.get('a'), [1])
+    self.assertIsNone(objects.get('b'))
+    self.assertIsNone(objects.get('c'))
+
+    with self.assertRaises((ValueError, RuntimeError)):
+      btree.CompressedStringMap2Int([('b', 1), ('a', 2)])
+
+  def test_range_aggregates(self):
+    tree = btree.BtreeMapInt2Int()
+    tree.insert_many([(i, i * 10) for i in range(10)])
+    self.assertEqual(tree.count_range(3, 7), 4)
+    self.assertEqual(tree.sum_range(3, 7), 30 + 40 + 50 + 60)
+    self.assertEqual(tree.min_range(3, 7), 30)
+    self.assertEqual(tree.max_range(3, 7), 60)
+    self.assertEqual(tree.sum_range(100, 200), 0)
+    self.assertEqual(tree.count_range(100, 200), 0)
+    self.assertEqual(tree.sum_range(7, 3), 0)
+    self.assertEqual(tree.count_range(7, 3), 0)
+    with self.assertRaises((ValueError, RuntimeError)):
+      tree.min_range(7, 3)
+
+  def test_reversed_views(self):
+    tree = btree.BtreeMapInt2Str()
+    tree.insert_many([(1, 'a'), (2, 'b'), (3, 'c')])
+    self.assertListEqual(list(tree.reversed_keys()), [3, 2, 1])
+    self.assertListEqual(list(tree.reversed_values()), ['c', 'b', 'a'])
+    self.assertListEqual(
+        list(tree.reversed_items()), [(3, 'c'), (2, 'b'), (1, 'a')]
+    )
+    # A tail scan only walks the requested prefix of the reversed view.
+    view = tree.reversed_keys()
+    self.assertListEqual(view.next_chunk(2), [3, 2])
+    self.assertListEqual(view.next_chunk(2), [1])
+    self.assertListEqual(view.next_chunk(2), [])
+
+  def test_snapshot(self):
+    tree = btree.BtreeMapInt2Str()
+    tree.insert_many([(1, 'a'), (2, 'b')])
+    clone = tree.snapshot()
+    tree[3] = 'c'
+    del tree[1]
+    # The snapshot keeps serving the state it was taken at.
+    self.assertListEqual(list(clone.items()), [(1, 'a'), (2, 'b')])
+    self.assertListEqual(list(tree.items()), [(2, 'b'), (3, 'c')])
+
+  def test_update_and_setdefault_many(self):
+    tree = btree.BtreeMapInt2Str()
+    tree.insert_many([(1, 'a'), (2, 'b')])
+    self.assertEqual(tree.update([(2, 'B'), (3, 'c')]), 1)
+    self.assertListEqual(list(tree.items()), [(1, 'a'), (2, 'B'), (3, 'c')])
+    self.assertEqual(tree.setdefault_many([(3, 'C'), (4, 'd')]), 1)
+    self.assertListEqual(
+        list(tree.items()), [(1, 'a'), (2, 'B'), (3, 'c'), (4, 'd')]
+    )
+
+  def test_get_does_not_insert(self):
+    tree = btree.BtreeMapInt2Str()
+    tree[1] = 'a'
+    self.assertEqual(tree.get(1), 'a')
+    self.assertEqual(tree.get(2), '')
+    self.assertEqual(tree.get(2, 'missing'), 'missing')
+    self.assertEqual(tree.strict_get(1), 'a')
+    # Unlike `__getitem__`, probing missing keys did not insert anything.
+    self.assertLen(tree, 1)
+
+    tree = btree.BtreeMapInt2Object()
+    tree[1] = 'a'
+    self.assertIsNone(tree.get(2))
+    self.assertEqual(tree.get(2, 'missing'), 'missing')
+    self.assertLen(tree, 1)
+
+  def test_erase_range(self):
+    tree = btree.BtreeMapInt2Str()
+    tree.insert_many([(i, str(i)) for i in range(10)])
+    self.assertEqual(tree.erase_range(3, 7), 4)
+    self.assertListEqual(list(tree), [0, 1, 2, 7, 8, 9])
+    self.assertEqual(tree.erase_range(100, 200), 0)
+    self.assertEqual(tree.erase_range(9, 0), 0)
+    self.assertLen(tree, 6)
+
+  def test_count_and_equal_range_list(self):
+    tree = btree.BtreeMultimapInt2Str()
+    tree.insert_many([(1, 'a'), (2, 'b'), (2, 'c'), (2, 'd'), (3, 'e')])
+    self.assertEqual(tree.count(2), 3)
+    self.assertEqual(tree.count(4), 0)
+    self.assertListEqual(
+        tree.equal_range_list(2), [(2, 'b'), (2, 'c'), (2, 'd')]
+    )
+    self.assertListEqual(tree.equal_range_list(4), [])
+
+    multiset = btree.BtreeMultisetInt()
+    multiset.insert_many([1, 2, 2, 2, 3])
+    self.assertEqual(multiset.count(2), 3)
+    self.assertListEqual(multiset.equal_range_list(2), [2, 2, 2])
+
+  def test_cursor(self):
+    tree = btree.BtreeSetInt()
+    tree.insert_many(list(range(0, 100, 2)))
+    cursor = tree.cursor()
+    # Sequential-ish probes: hits, misses, and small jumps in both directions.
+    for key in (10, 11, 12, 14, 13, 12, 50, 99, 0, -5, 200):
+      expected = key in set(range(0, 100, 2))
+      self.assertEqual(cursor.contains(key), expected)
+      it = cursor.find(key)
+      self.assertEqual(it != tree.end(), expected)
+      lb = cursor.lower_bound(key)
+      self.assertEqual(lb, tree.lower_bound(key))
+
+    # A size-changing mutation drops the cached position.
+    cursor.contains(10)
+    tree.insert(1)
+    self.assertTrue(cursor.contains(1))
+    self.assertFalse(cursor.contains(3))
+
+    strings = btree.BtreeMapStr2Int()
+    strings.insert_many([(c, ord(c)) for c in 'abcdef'])
+    str_cursor = strings.cursor()
+    self.assertTrue(str_cursor.contains('c'))
+    self.assertTrue(str_cursor.contains('d'))
+    self.assertFalse(str_cursor.contains('dd'))
+    self.assertEqual(str_cursor.lower_bound('e').deref(), ('e', ord('e')))
+
+  def test_erase_deferred(self):
+    tree = btree.BtreeMapInt2Object()
+    value = object()
+    tree[1] = value
+    tree[2] = 'x'
+    baseline = sys.getrefcount(value)
+
+    self.assertEqual(tree.erase_deferred(1), 1)
+    self.assertLen(tree, 1)
+    # The tree's reference is parked on the pending buffer, not released.
+    self.assertEqual(sys.getrefcount(value), baseline)
+
+    self.assertGreaterEqual(btree.flush_pending_decrefs(), 1)
+    self.assertEqual(sys.getrefcount(value), baseline - 1)
+    self.assertEqual(btree.flush_pending_decrefs(), 0)
+
+    self.assertEqual(tree.erase_deferred(42), 0)
+    # Native trees accept the call too; it is plain erase for them.
+    native = btree.BtreeSetInt()
+    native.insert_many([1, 2, 3])
+    self.assertEqual(native.erase_deferred(2), 1)
+    self.assertListEqual(list(native), [1, 3])
+
+  def test_tree_stats(self):
+    tree = btree.BtreeSetInt()
+    height, node_count, bytes_in_use, average_fill = tree.tree_stats()
+    self.assertEqual(height, 0)
+    self.assertEqual(node_count, 0)
+    self.assertEqual(bytes_in_use, 0)
+    self.assertEqual(average_fill, 0.0)
+
+    tree.insert_many(list(range(10000)))
+    height, node_count, bytes_in_use, average_fill = tree.tree_stats()
+    self.assertBetween(height, 1, 10)
+    self.assertGreater(node_count, 1)
+    self.assertGreater(bytes_in_use, 0)
+    self.assertBetween(average_fill, 0.0, 1.0)
+
+  def test_object_key_fast_path_order(self):
+    # Mix 64-bit-range and bignum ints to cross the fast path's overflow
+    # fallback, and check str keys against Python's own ordering.
+    for keys in ([2**100, -(2**100), -5, 0, 7, 2**62], ['b', 'a', 'ab', '']):
+      tree = btree.BtreeSetObject()
+      for key in keys:
+        tree.insert(key)
+      actual_keys = []
+      it = tree.begin()
+      while it != tree.end():
+        actual_keys.append(it.deref())
+        it.self_inc()
+      self.assertListEqual(actual_keys, sorted(keys))
+
+  def test_packed_tuple_key_order(self):
+    # The packed comparator must preserve lexicographic order across sign
+    # boundaries of every field.
+    tree = btree.BtreeSetIntInt()
+    keys = [(1, -1), (-1, 1), (0, 0), (-1, -2), (1, 2), (0, -3)]
+    tree.insert_many(keys)
+    self.assertListEqual(list(tree), sorted(keys))
+
+  def test_pop_first_and_pop_last(self):
+    tree = btree.BtreeMapInt2Str()
+    tree.insert_many([(2, 'b'), (1, 'a'), (3, 'c')])
+    self.assertEqual(tree.pop_first(), (1, 'a'))
+    self.assertEqual(tree.pop_last(), (3, 'c'))
+    self.assertEqual(tree.pop_first(), (2, 'b'))
+    self.assertEmpty(tree)
+
+  def test_merge_from(self):
+    lhs = btree.BtreeSetInt()
+    lhs.insert_many([1, 2, 3])
+    rhs = btree.BtreeSetInt()
+    rhs.insert_many([3, 4, 5])
+    lhs.merge_from(rhs)
+    self.assertListEqual(list(lhs), [1, 2, 3, 4, 5])
+    # The key already present on the left stays behind.
+    self.assertListEqual(list(rhs), [3])
+
+  def test_set_algebra(self):
+    lhs = btree.BtreeSetInt()
+    lhs.insert_many([1, 2, 3, 4])
+    rhs = btree.BtreeSetInt()
+    rhs.insert_many([3, 4, 5, 6])
+    self.assertListEqual(list(lhs.union_(rhs)), [1, 2, 3, 4, 5, 6])
+    self.assertListEqual(list(lhs.intersection(rhs)), [3, 4])
+    self.assertListEqual(list(lhs.difference(rhs)), [1, 2])
+    # The inputs are left untouched.
+    self.assertListEqual(list(lhs), [1, 2, 3, 4])
+    self.assertListEqual(list(rhs), [3, 4, 5, 6])
+
+  def test_nth_and_rank(self):
+    tree = btree.BtreeSetInt()
+    tree.insert_many([10, 20, 30, 40, 50])
+    self.assertEqual(tree.nth(0).deref(), 10)
+    self.assertEqual(tree.nth(2).deref(), 30)
+    self.assertEqual(tree.nth(4).deref(), 50)
+    self.assertEqual(tree.rank(10), 0)
+    self.assertEqual(tree.rank(35), 3)
+    self.assertEqual(tree.rank(100), 5)
+
+  def test_memory_stats(self):
+    tree = btree.BtreeMapInt2Int()
+    bytes_in_use, allocations_in_use, average_fill = tree.memory_stats()
+    self.assertEqual(bytes_in_use, 0)
+    self.assertEqual(allocations_in_use, 0)
+    self.assertEqual(average_fill, 0.0)
+
+    tree.insert_many([(i, i) for i in range(1000)])
+    bytes_in_use, allocations_in_use, average_fill = tree.memory_stats()
+    self.assertGreater(bytes_in_use, 0)
+    self.assertGreater(allocations_in_use, 0)
+    self.assertBetween(average_fill, 0.0, 1.0)
+
+    tree.clear()
+    bytes_in_use, allocations_in_use, average_fill = tree.memory_stats()
+    self.assertEqual(allocations_in_use, 0)
+    self.assertEqual(average_fill, 0.0)
+
+  def test_release_memory(self):
+    tree = btree.BtreeMapInt2Int()
+    tree.insert_many([(i, i) for i in range(10000)])
+    # Arena blocks interleave live and free nodes, so nothing can be released
+    # while elements are live.
+    self.assertEqual(tree.release_memory(), 0)
+    tree.clear()
+    self.assertGreater(tree.release_memory(), 0)
+    self.assertEqual(tree.release_memory(), 0)
+    # The pool keeps serving allocations after a release.
+    tree.insert_many([(i, i) for i in range(100)])
+    self.assertLen(tree, 100)
+    self.assertEqual(tree.get(42), 42)
+
+  def test_concurrent_map(self):
+    tree = btree.BtreeConcurrentMapInt2Str()
+    self.assertEmpty(tree)
+    self.assertTrue(tree.insert((1, 'a')))
+    self.assertFalse(tree.insert((1, 'b')))
+    tree[2] = 'b'
+    tree[2] = 'c'
+    self.assertLen(tree, 2)
+    self.assertIn(1, tree)
+    self.assertNotIn(3, tree)
+    self.assertEqual(tree.get(1), 'a')
+    self.assertEqual(tree.get(2), 'c')
+    self.assertEqual(tree.get(3), '')
+    self.assertEqual(tree.get(3, 'missing'), 'missing')
+    self.assertEqual(tree.insert_many([(3, 'd'), (3, 'e'), (4, 'f')]), 2)
+    self.assertListEqual(
+        tree.items_list(), [(1, 'a'), (2, 'c'), (3, 'd'), (4, 'f')]
+    )
+    self.assertEqual(tree.erase(3), 1)
+    self.assertEqual(tree.erase(3), 0)
+    del tree[4]
+    tree.clear()
+    self.assertEmpty(tree)
+
+  def test_concurrent_map_threads(self):
+    tree = btree.BtreeConcurrentMapInt2Int()
+    num_writers = 4
+    per_thread = 1000
+
+    def writer(thread_index: int) -> None:
+      for i in range(per_thread):
+        tree[thread_index * per_thread + i] = thread_index
+
+    def reader() -> None:
+      for i in range(num_writers * per_thread):
+        tree.get(i, -1)
+
+    threads = [
+        threading.Thread(target=writer, args=(t,)) for t in range(num_writers)
+    ] + [threading.Thread(target=reader) for _ in range(2)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+
+    self.assertLen(tree, num_writers * per_thread)
+    for t in range(num_writers):
+      self.assertEqual(tree.get(t * per_thread), t)
+    keys = [key for key, _ in tree.items_list()]
+    self.assertListEqual(keys, sorted(keys))
+
   def test_no_memory_leak(self):
     # Small integers with the same value correspond to the same object. CPython
     # caches small integers just like Java. Don't use small integers to monitor
@@ -12,12 +12,27 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
-"""Generates the CLIF file for B-tree."""
+"""Generates the CLIF files for B-tree.
+
+Run without arguments to print one monolithic CLIF file to stdout. With
+`--output_dir DIR`, the instantiations are split into one CLIF file per key
+family (`btree_int_keys.clif`, `btree_str_keys.clif`, `btree_tuple_keys.clif`,
+`btree_object_keys.clif`) plus a lazy umbrella `__init__.py`, so a process
+that only uses e.g. `BtreeMapInt2Int` imports and maps only the int-keyed
+extension module instead of every instantiation.
+"""
 
 import itertools
+import os
+import re
+import sys
 from typing import TypeAlias, Union
 
 _TEMPLATE_HEADER = """\
+from "btree/btree_utils.h":
+  namespace `djc::btree`:
+    def flush_pending_decrefs() -> int
+
 from "btree/btree.h":
   namespace `djc::btree`:
 """
@@ -30,9 +45,22 @@ _TEMPLATE_SETS = """\
       def `operator==` as __eq__(self, rhs: BtreeSet{KeyType}Iterator) -> bool
       def `operator!=` as __ne__(self, rhs: BtreeSet{KeyType}Iterator) -> bool
 
+    class `btree_set<{key_c_type}>::cursor_type` as _BtreeSet{KeyType}Cursor:
+      def `_contains` as contains(self, key: {key_type}) -> bool
+      def `_find` as find(self, key: {key_type}) -> BtreeSet{KeyType}Iterator
+      def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeSet{KeyType}Iterator
+
     class `btree_set<{key_c_type}>::keys_view_generator` as _BtreeSet{KeyType}KeysView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+
+    class `btree_set<{key_c_type}>::reversed_keys_view_generator` as _BtreeSet{KeyType}ReversedKeysView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
 
     class `btree_set<{key_c_type}>` as BtreeSet{KeyType}:
       def __init__(self) -> None
@@ -43,17 +71,42 @@ _TEMPLATE_SETS = """\
       def `_contains` as __contains__(self, key: {key_type}) -> bool
       def size(self) -> int
       def `size` as __len__(self) -> int
+      def memory_stats(self) -> tuple<int, int, float>
+      def tree_stats(self) -> tuple<int, int, int, float>
+      def release_memory(self) -> int
       def `_begin` as begin(self) -> BtreeSet{KeyType}Iterator
       def `_end` as end(self) -> BtreeSet{KeyType}Iterator
       def `_insert` as insert(self, key: {key_type}) -> tuple<BtreeSet{KeyType}Iterator, bool>
+      def `_insert_many` as insert_many(self, keys: list<{key_type}>) -> int
+      def `_from_sorted` as from_sorted(self, keys: list<{key_type}>) -> None
+      def insert_array(self, keys: object) -> int  # Arithmetic types only.
+      def extract_arrays(self) -> object  # Arithmetic types only.
+      def save(self, path: str) -> None
+      def load(self, path: str) -> None
+      def build_from_file(self, path: str, format: str) -> None  # It does not work on `object`.
       def `_erase` as erase(self, key: {key_type}) -> int
+      def `_erase_range` as erase_range(self, lo: {key_type}, hi: {key_type}) -> int
+      def `_erase_deferred` as erase_deferred(self, key: {key_type}) -> int
+      def `_count_range` as count_range(self, lo: {key_type}, hi: {key_type}) -> int
       def remove(self, it: BtreeSet{KeyType}Iterator) -> BtreeSet{KeyType}Iterator
+      def pop_first(self) -> {key_type}
+      def pop_last(self) -> {key_type}
+      def merge_from(self, other: BtreeSet{KeyType}) -> None
+      def snapshot(self) -> BtreeSet{KeyType}
+      def union_(self, rhs: BtreeSet{KeyType}) -> BtreeSet{KeyType}
+      def intersection(self, rhs: BtreeSet{KeyType}) -> BtreeSet{KeyType}
+      def difference(self, rhs: BtreeSet{KeyType}) -> BtreeSet{KeyType}
       def `_find` as find(self, key: {key_type}) -> BtreeSet{KeyType}Iterator
       def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeSet{KeyType}Iterator
       def `_upper_bound` as upper_bound(self, key: {key_type}) -> BtreeSet{KeyType}Iterator
+      def cursor(self) -> _BtreeSet{KeyType}Cursor
+      def nth(self, i: int) -> BtreeSet{KeyType}Iterator
+      def rank(self, key: {key_type}) -> int
+      def `_range` as range(self, lo: {key_type}, hi: {key_type}, limit: int = default) -> list<{key_type}>
       class `keys_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
       def keys(self) -> _BtreeSet{KeyType}KeysView  # It does not work on `object`.
+      def reversed_keys(self) -> _BtreeSet{KeyType}ReversedKeysView  # It does not work on `object`.
 
     class `btree_multiset<{key_c_type}>::iterator` as BtreeMultiset{KeyType}Iterator:
       def `operator++` as self_inc(self) -> BtreeMultiset{KeyType}Iterator
@@ -62,9 +115,22 @@ _TEMPLATE_SETS = """\
       def `operator==` as __eq__(self, rhs: BtreeMultiset{KeyType}Iterator) -> bool
       def `operator!=` as __ne__(self, rhs: BtreeMultiset{KeyType}Iterator) -> bool
 
+    class `btree_multiset<{key_c_type}>::cursor_type` as _BtreeMultiset{KeyType}Cursor:
+      def `_contains` as contains(self, key: {key_type}) -> bool
+      def `_find` as find(self, key: {key_type}) -> BtreeMultiset{KeyType}Iterator
+      def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeMultiset{KeyType}Iterator
+
     class `btree_multiset<{key_c_type}>::keys_view_generator` as _BtreeMultiset{KeyType}KeysView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+
+    class `btree_multiset<{key_c_type}>::reversed_keys_view_generator` as _BtreeMultiset{KeyType}ReversedKeysView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
 
     class `btree_multiset<{key_c_type}>` as BtreeMultiset{KeyType}:
       def __init__(self) -> None
@@ -75,17 +141,41 @@ _TEMPLATE_SETS = """\
       def `_contains` as __contains__(self, key: {key_type}) -> bool
       def size(self) -> int
       def `size` as __len__(self) -> int
+      def memory_stats(self) -> tuple<int, int, float>
+      def tree_stats(self) -> tuple<int, int, int, float>
+      def release_memory(self) -> int
       def `_begin` as begin(self) -> BtreeMultiset{KeyType}Iterator
       def `_end` as end(self) -> BtreeMultiset{KeyType}Iterator
       def `_insert` as insert(self, key: {key_type}) -> BtreeMultiset{KeyType}Iterator
+      def `_insert_many` as insert_many(self, keys: list<{key_type}>) -> int
+      def `_from_sorted` as from_sorted(self, keys: list<{key_type}>) -> None
+      def insert_array(self, keys: object) -> int  # Arithmetic types only.
+      def extract_arrays(self) -> object  # Arithmetic types only.
+      def save(self, path: str) -> None
+      def load(self, path: str) -> None
+      def build_from_file(self, path: str, format: str) -> None  # It does not work on `object`.
       def `_erase` as erase(self, key: {key_type}) -> int
+      def `_erase_range` as erase_range(self, lo: {key_type}, hi: {key_type}) -> int
+      def `_erase_deferred` as erase_deferred(self, key: {key_type}) -> int
+      def `_count_range` as count_range(self, lo: {key_type}, hi: {key_type}) -> int
       def remove(self, it: BtreeMultiset{KeyType}Iterator) -> BtreeMultiset{KeyType}Iterator
+      def pop_first(self) -> {key_type}
+      def pop_last(self) -> {key_type}
+      def merge_from(self, other: BtreeMultiset{KeyType}) -> None
+      def snapshot(self) -> BtreeMultiset{KeyType}
       def `_find` as find(self, key: {key_type}) -> BtreeMultiset{KeyType}Iterator
       def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeMultiset{KeyType}Iterator
       def `_upper_bound` as upper_bound(self, key: {key_type}) -> BtreeMultiset{KeyType}Iterator
+      def cursor(self) -> _BtreeMultiset{KeyType}Cursor
+      def `_count` as count(self, key: {key_type}) -> int
+      def `_equal_range_list` as equal_range_list(self, key: {key_type}) -> list<{key_type}>
+      def nth(self, i: int) -> BtreeMultiset{KeyType}Iterator
+      def rank(self, key: {key_type}) -> int
+      def `_range` as range(self, lo: {key_type}, hi: {key_type}, limit: int = default) -> list<{key_type}>
       class `keys_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
       def keys(self) -> _BtreeMultiset{KeyType}KeysView  # It does not work on `object`.
+      def reversed_keys(self) -> _BtreeMultiset{KeyType}ReversedKeysView  # It does not work on `object`.
 """
 
 _TEMPLATE_MAPS = """\
@@ -96,17 +186,46 @@ _TEMPLATE_MAPS = """\
       def `operator==` as __eq__(self, rhs: BtreeMap{KeyType}2{ValueType}Iterator) -> bool
       def `operator!=` as __ne__(self, rhs: BtreeMap{KeyType}2{ValueType}Iterator) -> bool
 
+    class `btree_map<{key_c_type}, {value_c_type}>::cursor_type` as _BtreeMap{KeyType}2{ValueType}Cursor:
+      def `_contains` as contains(self, key: {key_type}) -> bool
+      def `_find` as find(self, key: {key_type}) -> BtreeMap{KeyType}2{ValueType}Iterator
+      def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeMap{KeyType}2{ValueType}Iterator
+
     class `btree_map<{key_c_type}, {value_c_type}>::keys_view_generator` as _BtreeMap{KeyType}2{ValueType}KeysView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
 
     class `btree_map<{key_c_type}, {value_c_type}>::values_view_generator` as _Btreemap{KeyType}2{ValueType}ValuesView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {value_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
 
     class `btree_map<{key_c_type}, {value_c_type}>::items_view_generator` as _Btreemap{KeyType}2{ValueType}ItemsView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> tuple<{key_type}, {value_type}>  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
+
+    class `btree_map<{key_c_type}, {value_c_type}>::reversed_keys_view_generator` as _BtreeMap{KeyType}2{ValueType}ReversedKeysView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+
+    class `btree_map<{key_c_type}, {value_c_type}>::reversed_values_view_generator` as _Btreemap{KeyType}2{ValueType}ReversedValuesView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> {value_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
+
+    class `btree_map<{key_c_type}, {value_c_type}>::reversed_items_view_generator` as _Btreemap{KeyType}2{ValueType}ReversedItemsView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> tuple<{key_type}, {value_type}>  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
 
     class `btree_map<{key_c_type}, {value_c_type}>` as BtreeMap{KeyType}2{ValueType}:
       def __init__(self) -> None
@@ -117,16 +236,46 @@ _TEMPLATE_MAPS = """\
       def `_contains` as __contains__(self, key: {key_type}) -> bool
       def size(self) -> int
       def `size` as __len__(self) -> int
+      def memory_stats(self) -> tuple<int, int, float>
+      def tree_stats(self) -> tuple<int, int, int, float>
+      def release_memory(self) -> int
       def `_begin` as begin(self) -> BtreeMap{KeyType}2{ValueType}Iterator
       def `_end` as end(self) -> BtreeMap{KeyType}2{ValueType}Iterator
       def `_insert` as insert(self, value: tuple<{key_type}, {value_type}>) -> tuple<BtreeMap{KeyType}2{ValueType}Iterator, bool>
+      def `_insert_many` as insert_many(self, values: list<tuple<{key_type}, {value_type}>>) -> int
+      def `_from_sorted` as from_sorted(self, values: list<tuple<{key_type}, {value_type}>>) -> None
+      def insert_array(self, keys: object, values: object) -> int  # Arithmetic types only.
+      def extract_arrays(self) -> object  # Arithmetic types only.
+      def save(self, path: str) -> None
+      def load(self, path: str) -> None
+      def build_from_file(self, path: str, format: str) -> None  # It does not work on `object`.
+      def freeze(self, path: str) -> None  # Arithmetic types only.
       def `_erase` as erase(self, key: {key_type}) -> int
+      def `_erase_range` as erase_range(self, lo: {key_type}, hi: {key_type}) -> int
+      def `_erase_deferred` as erase_deferred(self, key: {key_type}) -> int
+      def `_count_range` as count_range(self, lo: {key_type}, hi: {key_type}) -> int
       def `_erase` as __delitem__(self, key: {key_type}) -> None
       def remove(self, it: BtreeMap{KeyType}2{ValueType}Iterator) -> BtreeMap{KeyType}2{ValueType}Iterator
+      def pop_first(self) -> tuple<{key_type}, {value_type}>
+      def pop_last(self) -> tuple<{key_type}, {value_type}>
+      def merge_from(self, other: BtreeMap{KeyType}2{ValueType}) -> None
+      def snapshot(self) -> BtreeMap{KeyType}2{ValueType}
       def `_find` as find(self, key: {key_type}) -> BtreeMap{KeyType}2{ValueType}Iterator
       def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeMap{KeyType}2{ValueType}Iterator
       def `_upper_bound` as upper_bound(self, key: {key_type}) -> BtreeMap{KeyType}2{ValueType}Iterator
+      def cursor(self) -> _BtreeMap{KeyType}2{ValueType}Cursor
+      def nth(self, i: int) -> BtreeMap{KeyType}2{ValueType}Iterator
+      def rank(self, key: {key_type}) -> int
+      def `_range` as range(self, lo: {key_type}, hi: {key_type}, limit: int = default) -> list<tuple<{key_type}, {value_type}>>
       def insert_or_assign(self, key: {key_type}, value: {value_type}) -> tuple<BtreeMap{KeyType}2{ValueType}Iterator, bool>
+      def sum_range(self, lo: {key_type}, hi: {key_type}) -> {value_type}  # Arithmetic values only.
+      def min_range(self, lo: {key_type}, hi: {key_type}) -> {value_type}  # Arithmetic values only.
+      def max_range(self, lo: {key_type}, hi: {key_type}) -> {value_type}  # Arithmetic values only.
+      def insert_or_assign_many(self, values: list<tuple<{key_type}, {value_type}>>) -> int
+      def `insert_or_assign_many` as update(self, values: list<tuple<{key_type}, {value_type}>>) -> int
+      def setdefault_many(self, values: list<tuple<{key_type}, {value_type}>>) -> int
+      def get(self, key: {key_type}, default_value: {value_type} = default) -> {value_type}
+      def strict_get(self, key: {key_type}) -> {value_type}
       def `get_item` as __getitem__(self, key: {key_type}) -> {value_type}
       def `insert_or_assign` as __setitem__(self, key: {key_type}, value: {value_type}) -> None
       class `keys_view` as __iter__:  # It does not work on `object`.
@@ -134,6 +283,9 @@ _TEMPLATE_MAPS = """\
       def keys(self) -> _BtreeMap{KeyType}2{ValueType}KeysView  # It does not work on `object`.
       def values(self) -> _Btreemap{KeyType}2{ValueType}ValuesView  # It does not work on `object`.
       def items(self) -> _Btreemap{KeyType}2{ValueType}ItemsView  # It does not work on `object`.
+      def reversed_keys(self) -> _BtreeMap{KeyType}2{ValueType}ReversedKeysView  # It does not work on `object`.
+      def reversed_values(self) -> _Btreemap{KeyType}2{ValueType}ReversedValuesView  # It does not work on `object`.
+      def reversed_items(self) -> _Btreemap{KeyType}2{ValueType}ReversedItemsView  # It does not work on `object`.
 
     class `btree_multimap<{key_c_type}, {value_c_type}>::iterator` as BtreeMultimap{KeyType}2{ValueType}Iterator:
       def `operator++` as self_inc(self) -> BtreeMultimap{KeyType}2{ValueType}Iterator
@@ -142,17 +294,46 @@ _TEMPLATE_MAPS = """\
       def `operator==` as __eq__(self, rhs: BtreeMultimap{KeyType}2{ValueType}Iterator) -> bool
       def `operator!=` as __ne__(self, rhs: BtreeMultimap{KeyType}2{ValueType}Iterator) -> bool
 
+    class `btree_multimap<{key_c_type}, {value_c_type}>::cursor_type` as _BtreeMultimap{KeyType}2{ValueType}Cursor:
+      def `_contains` as contains(self, key: {key_type}) -> bool
+      def `_find` as find(self, key: {key_type}) -> BtreeMultimap{KeyType}2{ValueType}Iterator
+      def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeMultimap{KeyType}2{ValueType}Iterator
+
     class `btree_multimap<{key_c_type}, {value_c_type}>::keys_view_generator` as _BtreeMultimap{KeyType}2{ValueType}KeysView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
 
     class `btree_multimap<{key_c_type}, {value_c_type}>::values_view_generator` as _BtreeMultimap{KeyType}2{ValueType}ValuesView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {value_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
 
     class `btree_multimap<{key_c_type}, {value_c_type}>::items_view_generator` as _BtreeMultimap{KeyType}2{ValueType}ItemsView:  # It does not work on `object`.
       class `btree_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> tuple<{key_type}, {value_type}>  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
+
+    class `btree_multimap<{key_c_type}, {value_c_type}>::reversed_keys_view_generator` as _BtreeMultimap{KeyType}2{ValueType}ReversedKeysView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> {key_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{key_type}>  # It does not work on `object`.
+
+    class `btree_multimap<{key_c_type}, {value_c_type}>::reversed_values_view_generator` as _BtreeMultimap{KeyType}2{ValueType}ReversedValuesView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> {value_type}  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<{value_type}>  # It does not work on `object`.
+
+    class `btree_multimap<{key_c_type}, {value_c_type}>::reversed_items_view_generator` as _BtreeMultimap{KeyType}2{ValueType}ReversedItemsView:  # It does not work on `object`.
+      class `btree_view` as __iter__:  # It does not work on `object`.
+        def __next__(self) -> tuple<{key_type}, {value_type}>  # It does not work on `object`.
+      def next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
+      def prefetch_next_chunk(self, n: int) -> list<tuple<{key_type}, {value_type}>>  # It does not work on `object`.
 
     class `btree_multimap<{key_c_type}, {value_c_type}>` as BtreeMultimap{KeyType}2{ValueType}:
       def __init__(self) -> None
@@ -163,19 +344,93 @@ _TEMPLATE_MAPS = """\
       def `_contains` as __contains__(self, key: {key_type}) -> bool
       def size(self) -> int
       def `size` as __len__(self) -> int
+      def memory_stats(self) -> tuple<int, int, float>
+      def tree_stats(self) -> tuple<int, int, int, float>
+      def release_memory(self) -> int
       def `_begin` as begin(self) -> BtreeMultimap{KeyType}2{ValueType}Iterator
       def `_end` as end(self) -> BtreeMultimap{KeyType}2{ValueType}Iterator
       def `_insert` as insert(self, value: tuple<{key_type}, {value_type}>) -> BtreeMultimap{KeyType}2{ValueType}Iterator
+      def `_insert_many` as insert_many(self, values: list<tuple<{key_type}, {value_type}>>) -> int
+      def `_from_sorted` as from_sorted(self, values: list<tuple<{key_type}, {value_type}>>) -> None
+      def insert_array(self, keys: object, values: object) -> int  # Arithmetic types only.
+      def extract_arrays(self) -> object  # Arithmetic types only.
+      def save(self, path: str) -> None
+      def load(self, path: str) -> None
+      def build_from_file(self, path: str, format: str) -> None  # It does not work on `object`.
       def `_erase` as erase(self, key: {key_type}) -> int
+      def `_erase_range` as erase_range(self, lo: {key_type}, hi: {key_type}) -> int
+      def `_erase_deferred` as erase_deferred(self, key: {key_type}) -> int
+      def `_count_range` as count_range(self, lo: {key_type}, hi: {key_type}) -> int
       def remove(self, it: BtreeMultimap{KeyType}2{ValueType}Iterator) -> BtreeMultimap{KeyType}2{ValueType}Iterator
+      def pop_first(self) -> tuple<{key_type}, {value_type}>
+      def pop_last(self) -> tuple<{key_type}, {value_type}>
+      def merge_from(self, other: BtreeMultimap{KeyType}2{ValueType}) -> None
+      def snapshot(self) -> BtreeMultimap{KeyType}2{ValueType}
       def `_find` as find(self, key: {key_type}) -> BtreeMultimap{KeyType}2{ValueType}Iterator
       def `_lower_bound` as lower_bound(self, key: {key_type}) -> BtreeMultimap{KeyType}2{ValueType}Iterator
       def `_upper_bound` as upper_bound(self, key: {key_type}) -> BtreeMultimap{KeyType}2{ValueType}Iterator
+      def cursor(self) -> _BtreeMultimap{KeyType}2{ValueType}Cursor
+      def `_count` as count(self, key: {key_type}) -> int
+      def `_equal_range_list` as equal_range_list(self, key: {key_type}) -> list<tuple<{key_type}, {value_type}>>
+      def nth(self, i: int) -> BtreeMultimap{KeyType}2{ValueType}Iterator
+      def rank(self, key: {key_type}) -> int
+      def `_range` as range(self, lo: {key_type}, hi: {key_type}, limit: int = default) -> list<tuple<{key_type}, {value_type}>>
       class `keys_view` as __iter__:  # It does not work on `object`.
         def __next__(self) -> {key_type}  # It does not work on `object`.
       def keys(self) -> _BtreeMultimap{KeyType}2{ValueType}KeysView  # It does not work on `object`.
       def values(self) -> _BtreeMultimap{KeyType}2{ValueType}ValuesView  # It does not work on `object`.
       def items(self) -> _BtreeMultimap{KeyType}2{ValueType}ItemsView  # It does not work on `object`.
+      def reversed_keys(self) -> _BtreeMultimap{KeyType}2{ValueType}ReversedKeysView  # It does not work on `object`.
+      def reversed_values(self) -> _BtreeMultimap{KeyType}2{ValueType}ReversedValuesView  # It does not work on `object`.
+      def reversed_items(self) -> _BtreeMultimap{KeyType}2{ValueType}ReversedItemsView  # It does not work on `object`.
+"""
+
+_TEMPLATE_FROZEN_MAPS = """\
+    class `frozen_btree_map<{key_c_type}, {value_c_type}>` as FrozenBtreeMap{KeyType}2{ValueType}:
+      def __init__(self, path: str)
+      def empty(self) -> bool
+      def `not_empty` as __bool__(self) -> bool
+      def `_contains` as contains(self, key: {key_type}) -> bool
+      def `_contains` as __contains__(self, key: {key_type}) -> bool
+      def size(self) -> int
+      def `size` as __len__(self) -> int
+      def get(self, key: {key_type}, default_value: {value_type} = default) -> {value_type}
+      def `_range` as range(self, lo: {key_type}, hi: {key_type}, limit: int = default) -> list<tuple<{key_type}, {value_type}>>
+"""
+
+_TEMPLATE_COMPRESSED_MAPS = """\
+    class `compressed_string_map<{value_c_type}>` as CompressedStringMap2{ValueType}:
+      def __init__(self, items: list<tuple<str, {value_type}>>)
+      def empty(self) -> bool
+      def `not_empty` as __bool__(self) -> bool
+      def `_contains` as contains(self, key: str) -> bool
+      def `_contains` as __contains__(self, key: str) -> bool
+      def size(self) -> int
+      def `size` as __len__(self) -> int
+      def memory_stats(self) -> tuple<int, int>
+      def get(self, key: str, default_value: {value_type} = default) -> {value_type}
+      def `_range` as range(self, lo: str, hi: str, limit: int = default) -> list<tuple<str, {value_type}>>
+      def `_items_list` as items_list(self) -> list<tuple<str, {value_type}>>
+"""
+
+_TEMPLATE_CONCURRENT_MAPS = """\
+    class `btree_concurrent_map<{key_c_type}, {value_c_type}>` as BtreeConcurrentMap{KeyType}2{ValueType}:
+      def __init__(self) -> None
+      def `_clear` as clear(self) -> None
+      def empty(self) -> bool
+      def `not_empty` as __bool__(self) -> bool
+      def `_contains` as contains(self, key: {key_type}) -> bool
+      def `_contains` as __contains__(self, key: {key_type}) -> bool
+      def get(self, key: {key_type}, default_value: {value_type} = default) -> {value_type}
+      def size(self) -> int
+      def `size` as __len__(self) -> int
+      def `_insert` as insert(self, value: tuple<{key_type}, {value_type}>) -> bool
+      def `_insert_many` as insert_many(self, values: list<tuple<{key_type}, {value_type}>>) -> int
+      def insert_or_assign(self, key: {key_type}, value: {value_type}) -> bool
+      def `insert_or_assign` as __setitem__(self, key: {key_type}, value: {value_type}) -> None
+      def `_erase` as erase(self, key: {key_type}) -> int
+      def `_erase` as __delitem__(self, key: {key_type}) -> None
+      def `_items_list` as items_list(self) -> list<tuple<{key_type}, {value_type}>>
 """
 
 _ELEMENTARY_TYPES = (int, float, str)
@@ -236,8 +491,119 @@ def _remove_unsupported_lines(text: str) -> str:
   return '\n'.join(lines)
 
 
+def _is_arithmetic(types: tuple[type[_ElementaryTypes], ...]) -> bool:
+  return len(types) == 1 and types[0] in (int, float)
+
+
+# String-keyed trees route point lookups through the `string_view` overloads
+# in `btree.h` (`_contains_view` etc.), so CLIF passes the UTF-8 buffer of the
+# Python str without materializing a `std::string` per probe.
+_VIEW_LOOKUP_RENAMES = (
+    ('def `_contains`', 'def `_contains_view`'),
+    ('def `_find`', 'def `_find_view`'),
+    ('def `_lower_bound`', 'def `_lower_bound_view`'),
+    ('def `_upper_bound`', 'def `_upper_bound_view`'),
+)
+
+
+def _use_view_lookups(text: str) -> str:
+  for old, new in _VIEW_LOOKUP_RENAMES:
+    text = text.replace(old, new)
+  return text
+
+
+# Buffer-protocol methods only exist (via `requires` clauses in `btree.h`) on
+# instantiations whose element types are arithmetic.
+def _remove_non_arithmetic_lines(text: str) -> str:
+  lines = text.split('\n')
+  lines = [
+      line for line in lines if not line.endswith('# Arithmetic types only.')
+  ]
+  return '\n'.join(lines)
+
+
+# The range-aggregation kernels only require the *value* type to be
+# arithmetic; the key type may be anything.
+def _remove_non_arithmetic_value_lines(text: str) -> str:
+  lines = text.split('\n')
+  lines = [
+      line for line in lines if not line.endswith('# Arithmetic values only.')
+  ]
+  return '\n'.join(lines)
+
+
+# Key families, in emission order. Each becomes its own CLIF file (and hence
+# its own extension module) in `--output_dir` mode.
+_KEY_FAMILIES = ('int_keys', 'str_keys', 'tuple_keys', 'object_keys')
+
+_INIT_TEMPLATE = '''\
+"""Lazy umbrella over the per-key-family B-tree extension modules.
+
+Generated by gen_btree_clif.py; do not edit. Accessing a class imports only
+the extension module of its key family.
+"""
+
+import importlib
+
+_MODULE_BY_CLASS = {{
+{module_by_class}}}
+
+
+def __getattr__(name):
+  module_name = _MODULE_BY_CLASS.get(name)
+  if module_name is None:
+    raise AttributeError(f'module {{__name__!r}} has no attribute {{name!r}}')
+  return getattr(importlib.import_module(f'{{__name__}}.{{module_name}}'), name)
+
+
+def __dir__():
+  return sorted(set(globals()) | set(_MODULE_BY_CLASS))
+'''
+
+
+def _key_family(key_types: tuple[type[_ElementaryTypes], ...]) -> str:
+  if len(key_types) > 1:
+    return 'tuple_keys'
+  return {int: 'int_keys', str: 'str_keys', object: 'object_keys'}[
+      key_types[0]
+  ]
+
+
+def _public_class_names(text: str) -> list[str]:
+  return re.findall(r'^    class `[^`]+` as ([A-Z]\w+):', text, re.MULTILINE)
+
+
+def _write_output(sections: dict[str, list[str]], output_dir: str) -> None:
+  module_by_class_lines = []
+  for family in _KEY_FAMILIES:
+    module_name = f'btree_{family}'
+    path = os.path.join(output_dir, f'{module_name}.clif')
+    with open(path, 'w') as clif_file:
+      clif_file.write(_TEMPLATE_HEADER + '\n')
+      clif_file.write('\n'.join(sections[family]))
+    for class_name in sorted(
+        name
+        for text in sections[family]
+        for name in _public_class_names(text)
+    ):
+      module_by_class_lines.append(f"    '{class_name}': '{module_name}',\n")
+  # The header's module-level functions are wrapped into every family module;
+  # route them through the object-keyed one, which deferred reclamation
+  # exists to serve.
+  module_by_class_lines.append(
+      "    'flush_pending_decrefs': 'btree_object_keys',\n"
+  )
+  with open(os.path.join(output_dir, '__init__.py'), 'w') as init_file:
+    init_file.write(
+        _INIT_TEMPLATE.format(module_by_class=''.join(module_by_class_lines))
+    )
+
+
 def main() -> None:
-  print(_TEMPLATE_HEADER)
+  sections = {family: [] for family in _KEY_FAMILIES}
+
+  def emit(key_types: tuple[type[_ElementaryTypes], ...], text: str) -> None:
+    sections[_key_family(key_types)].append(text)
 
   for key_tuple_len in range(1, _MAX_KEY_TUPLE_LEN + 1):
     # The type `float` is not considered as keys since it will lose precision
@@ -247,14 +613,17 @@ def main() -> None:
         for types in itertools.product(*((_ELEMENTARY_TYPES,) * key_tuple_len))
         if not _is_clif_bug_type(types) and float not in types
     ):
-      print(
-          _TEMPLATE_SETS.format(
-              key_type=_get_type_repr(key_types),
-              key_c_type=_get_c_type_repr(key_types),
-              KeyType=_get_capitalized_type_repr(key_types),
-          )
+      sets_text = _TEMPLATE_SETS.format(
+          key_type=_get_type_repr(key_types),
+          key_c_type=_get_c_type_repr(key_types),
+          KeyType=_get_capitalized_type_repr(key_types),
       )
-      print(
+      if not _is_arithmetic(key_types):
+        sets_text = _remove_non_arithmetic_lines(sets_text)
+      if key_types == (str,):
+        sets_text = _use_view_lookups(sets_text)
+      emit(key_types, sets_text)
+      maps_text = _remove_non_arithmetic_lines(
           _remove_unsupported_lines(
               _TEMPLATE_MAPS.format(
                   key_type=_get_type_repr(key_types),
@@ -266,13 +635,67 @@ def main() -> None:
               )
           )
       )
+      maps_text = _remove_non_arithmetic_value_lines(maps_text)
+      if key_types == (str,):
+        maps_text = _use_view_lookups(maps_text)
+      emit(key_types, maps_text)
+      if key_types == (str,):
+        emit(
+            key_types,
+            _TEMPLATE_COMPRESSED_MAPS.format(
+                value_type=_get_type_repr((object,)),
+                value_c_type=_get_c_type_repr((object,)),
+                ValueType=_get_capitalized_type_repr((object,)),
+            )
+        )
 
   for key_type, value_type in itertools.product(
       (tp for tp in _ELEMENTARY_TYPES if tp is not float),
       _ELEMENTARY_TYPES,
   ):
-    print(
-        _TEMPLATE_MAPS.format(
+    maps_text = _TEMPLATE_MAPS.format(
+        key_type=_get_type_repr((key_type,)),
+        key_c_type=_get_c_type_repr((key_type,)),
+        KeyType=_get_capitalized_type_repr((key_type,)),
+        value_type=_get_type_repr((value_type,)),
+        value_c_type=_get_c_type_repr((value_type,)),
+        ValueType=_get_capitalized_type_repr((value_type,)),
+    )
+    if not (_is_arithmetic((key_type,)) and _is_arithmetic((value_type,))):
+      maps_text = _remove_non_arithmetic_lines(maps_text)
+    if not _is_arithmetic((value_type,)):
+      maps_text = _remove_non_arithmetic_value_lines(maps_text)
+    if key_type is str:
+      maps_text = _use_view_lookups(maps_text)
+    emit((key_type,), maps_text)
+    if _is_arithmetic((key_type,)) and _is_arithmetic((value_type,)):
+      # The frozen map stores fixed-width elements only.
+      emit(
+          (key_type,),
+          _TEMPLATE_FROZEN_MAPS.format(
+              key_type=_get_type_repr((key_type,)),
+              key_c_type=_get_c_type_repr((key_type,)),
+              KeyType=_get_capitalized_type_repr((key_type,)),
+              value_type=_get_type_repr((value_type,)),
+              value_c_type=_get_c_type_repr((value_type,)),
+              ValueType=_get_capitalized_type_repr((value_type,)),
+          )
+      )
+    if key_type is str:
+      # The front-coded map only exists for string keys.
+      emit(
+          (key_type,),
+          _TEMPLATE_COMPRESSED_MAPS.format(
+              value_type=_get_type_repr((value_type,)),
+              value_c_type=_get_c_type_repr((value_type,)),
+              ValueType=_get_capitalized_type_repr((value_type,)),
+          )
+      )
+    # The concurrent map shards by `std::hash`, so it is only instantiated for
+    # scalar keys.
+    emit(
+        (key_type,),
+        _TEMPLATE_CONCURRENT_MAPS.format(
             key_type=_get_type_repr((key_type,)),
             key_c_type=_get_c_type_repr((key_type,)),
             KeyType=_get_capitalized_type_repr((key_type,)),
@@ -282,28 +705,44 @@ def main() -> None:
         )
     )
 
-  print(
-      _remove_unsupported_lines(
-          _TEMPLATE_SETS.format(
-              key_type=_get_type_repr((object,)),
-              key_c_type=_get_c_type_repr((object,)),
-              KeyType=_get_capitalized_type_repr((object,)),
+  emit(
+      (object,),
+      _remove_non_arithmetic_lines(
+          _remove_unsupported_lines(
+              _TEMPLATE_SETS.format(
+                  key_type=_get_type_repr((object,)),
+                  key_c_type=_get_c_type_repr((object,)),
+                  KeyType=_get_capitalized_type_repr((object,)),
+              )
           )
-      )
+      ),
   )
-  print(
-      _remove_unsupported_lines(
-          _TEMPLATE_MAPS.format(
-              key_type=_get_type_repr((object,)),
-              key_c_type=_get_c_type_repr((object,)),
-              KeyType=_get_capitalized_type_repr((object,)),
-              value_type=_get_type_repr((object,)),
-              value_c_type=_get_c_type_repr((object,)),
-              ValueType=_get_capitalized_type_repr((object,)),
+  emit(
+      (object,),
+      _remove_non_arithmetic_value_lines(
+          _remove_non_arithmetic_lines(
+              _remove_unsupported_lines(
+                  _TEMPLATE_MAPS.format(
+                      key_type=_get_type_repr((object,)),
+                      key_c_type=_get_c_type_repr((object,)),
+                      KeyType=_get_capitalized_type_repr((object,)),
+                      value_type=_get_type_repr((object,)),
+                      value_c_type=_get_c_type_repr((object,)),
+                      ValueType=_get_capitalized_type_repr((object,)),
+                  )
+              )
           )
-      )
+      ),
   )
 
+  if len(sys.argv) == 3 and sys.argv[1] == '--output_dir':
+    _write_output(sections, sys.argv[2])
+  else:
+    print(_TEMPLATE_HEADER)
+    for family in _KEY_FAMILIES:
+      for text in sections[family]:
+        print(text)
+
 
 if __name__ == '__main__':
   main()